@@ -0,0 +1,134 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_trie_frozen.h"
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+namespace yay {
+
+/// aho-corasick automaton compiled from a char_trie
+/// finds every dictionary string occurring anywhere in the buffer in one pass
+/// (as opposed to char_trie::matchString which only matches at one starting position)
+///
+/// nodes whose data equals noValue (the default value passed to char_trie::add for
+/// intermediate nodes) are not reported
+///
+/// CB must have bool operator()( size_t offset, size_t length, const D& data )
+/// it's invoked for every match, when it returns false scanning stops. cb can be a temporary (lambda)
+/// matches ending at the same position are reported longest first
+template <typename D>
+class aho_corasick {
+public:
+	typedef frozen_trie<char,D> Frozen;
+	typedef typename Frozen::node node;
+private:
+	Frozen d_trie;      // goto function
+	std::vector< uint32_t > d_fail;   // d_fail[n] - longest proper suffix of n which is in the trie
+	std::vector< uint32_t > d_out;    // d_out[n] - next reportable node on the failure chain of n (0 - none)
+	std::vector< uint32_t > d_depth;  // length of the string spelled by n
+	D d_noValue;
+
+	bool isTerminal( uint32_t n ) const { return !(d_trie.getNode(n).data() == d_noValue); }
+
+	/// goto for state n with fallback along the failure links
+	inline uint32_t nextState( uint32_t n, char c ) const
+	{
+		while( true ) {
+			const node* x = d_trie.find( &(d_trie.getNode(n)), c );
+			if( x )
+				return d_trie.getNodeIdx(x);
+			else if( !n )
+				return 0;
+			n = d_fail[n];
+		}
+	}
+public:
+	aho_corasick( const D& noValue = D() ) : d_noValue(noValue) {}
+	aho_corasick( const trie<char,D>& t, const D& noValue = D() ) : d_noValue(noValue)
+		{ compile(t); }
+
+	void clear()
+	{
+		d_trie.clear();
+		d_fail.clear();
+		d_out.clear();
+		d_depth.clear();
+	}
+	/// builds the automaton. t can be destroyed afterwards
+	/// noValue is the one given to the constructor
+	void compile( const trie<char,D>& t )
+	{
+		clear();
+		d_trie.freeze(t);
+
+		size_t numNodes = d_trie.getNumNodes();
+		d_fail.resize( numNodes, 0 );
+		d_out.resize( numNodes, 0 );
+		d_depth.resize( numNodes, 0 );
+
+		// frozen nodes are in breadth first order so failure links of all
+		// shallower nodes are known by the time we get to the node
+		for( size_t i = 0; i< numNodes; ++i ) {
+			const node* n = &(d_trie.getNode(i));
+			const char* k = d_trie.childKeyBegin(n);
+			for( const node* c = d_trie.childBegin(n), *c_end = d_trie.childEnd(n); c!= c_end; ++c, ++k ) {
+				uint32_t ci = d_trie.getNodeIdx(c);
+				d_depth[ci] = d_depth[i]+1;
+
+				uint32_t f = ( i ? nextState(d_fail[i], *k) : 0 );
+				d_fail[ci] = f;
+				d_out[ci] = ( isTerminal(f) && f ? f : d_out[f] );
+			}
+		}
+	}
+
+	size_t getNumNodes() const { return d_trie.getNumNodes(); }
+
+	/// scans buf of size buf_sz. returns number of matches reported
+	template <typename CB>
+	size_t scan( const char* buf, size_t buf_sz, CB&& cb ) const
+	{
+		if( d_trie.empty() )
+			return 0;
+		size_t numMatches = 0;
+		uint32_t state = 0;
+		for( size_t i = 0; i< buf_sz; ++i ) {
+			state = nextState( state, buf[i] );
+			for( uint32_t n = ( isTerminal(state) ? state : d_out[state] ); n; n = d_out[n] ) {
+				++numMatches;
+				if( !cb( i+1-d_depth[n], d_depth[n], d_trie.getNode(n).data() ) )
+					return numMatches;
+			}
+		}
+		return numMatches;
+	}
+	template <typename CB>
+	size_t scan( const char* s, CB&& cb ) const
+		{ return scan( s, strlen(s), std::forward<CB>(cb) ); }
+};
+
+} // namespace yay
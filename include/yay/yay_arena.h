@@ -0,0 +1,66 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_headers.h>
+#include <vector>
+#include <stdint.h>
+
+namespace yay {
+
+/// bump allocator - memory is handed out sequentially from big chunks 
+/// and is only ever freed all at once (clear or destructor)
+/// nothing is constructed or destroyed - it's up to the caller 
+class bump_arena {
+	size_t d_chunkCapacity; // capacity of regular chunks
+	size_t d_chunkSz;       // bytes used in the current chunk
+	size_t d_bytesUsed;     // total bytes handed out 
+
+	typedef std::vector< char* > ChunkVec;
+	ChunkVec d_chunk; // d_chunk.back() is the current chunk
+
+	char* addNewChunk( size_t sz );
+public:
+	bump_arena(const bump_arena&) = delete;
+	bump_arena& operator=(const bump_arena&) = delete;
+
+	enum { DEFAULT_CHUNK_SIZE = 256*1024 };
+	bump_arena( size_t cSz = DEFAULT_CHUNK_SIZE );
+	~bump_arena();
+
+	/// align must be a power of 2
+	void* alloc( size_t sz, size_t align = sizeof(void*) );
+
+	template <typename T>
+	T* allocArray( size_t n ) 
+		{ return (T*)alloc( n*sizeof(T), alignof(T) ); }
+
+	/// frees all memory
+	void clear();
+
+	size_t getNumChunks() const { return d_chunk.size(); }
+	size_t getBytesUsed() const { return d_bytesUsed; }
+};
+
+} // namespace yay
@@ -97,16 +97,16 @@ public:
     {
         const uint8_t* x = buf;
 
-        if( sizeof(x) == 1 ) {
+        if( sizeof(buf) == 1 ) {
             return *x;
-        } else if( sizeof(x) == 2 ) {
+        } else if( sizeof(buf) == 2 ) {
             return x[0] || x[1];
-        } else if( sizeof(x) == 3 ) {
+        } else if( sizeof(buf) == 3 ) {
             return ( x[0] || x[1] || x[2] );
-        } else if( sizeof(x) == 4 ) {
-            return ( x[0] || x[1] || x[2] || x[4] );
+        } else if( sizeof(buf) == 4 ) {
+            return ( x[0] || x[1] || x[2] || x[3] );
         } else {
-            for( auto i = x, i_end = i+sizeof(x); i< i_end; ++i ) {
+            for( auto i = x, i_end = i+sizeof(buf); i< i_end; ++i ) {
                 if( *i )
                     return true;
             }
@@ -0,0 +1,148 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_headers.h>
+#include <yay/yay_math.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+
+namespace yay {
+
+/// blocked bloom filter over 64 bit hashes
+/// every key touches a single 64 byte block (one cache line), so a negative lookup is one memory 
+/// access instead of k. costs a bit more memory than a classic bloom filter for the same false 
+/// positive rate - blocks get 20% more bits to make up for it
+/// keys arent rehashed - give it a good 64 bit hash (char_span_hash etc.)
+///     yay::blocked_bloom_filter bf( 1000000, 0.01 );
+///     bf.add( h );
+///     if( !bf.mayContain(h) ) ... definitely not there
+class blocked_bloom_filter {
+	enum : size_t { 
+		BLOCK_WORDS = 8,  // 512 bits
+		BLOCK_BITS = BLOCK_WORDS*64 
+	};
+	std::vector< uint64_t > d_bits;
+	size_t   d_numBlocks;
+	unsigned d_k;         // bits per key
+	size_t   d_numKeys;   // keys added
+	size_t   d_capacity;  // keys the filter was sized for
+	double   d_fpRate;
+
+	static uint64_t mix( uint64_t h )
+	{
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		return h;
+	}
+	const uint64_t* block( uint64_t h ) const 
+		{ return &(d_bits[ (size_t)mul_hi64( h, d_numBlocks ) * BLOCK_WORDS ]); }
+public:
+	blocked_bloom_filter() : d_numBlocks(0), d_k(0), d_numKeys(0), d_capacity(0), d_fpRate(0) {}
+	blocked_bloom_filter( size_t expectedKeys, double fpRate ) : 
+		d_numBlocks(0), d_k(0), d_numKeys(0), d_capacity(0), d_fpRate(0)
+		{ init( expectedKeys, fpRate ); }
+
+	/// sizes the filter for expectedKeys at fpRate false positives (0 < fpRate < 1) and clears it
+	void init( size_t expectedKeys, double fpRate )
+	{
+		if( fpRate <= 0 || fpRate >= 1 ) 
+			fpRate = 0.01;
+		if( !expectedKeys ) 
+			expectedKeys = 1;
+		const double ln2 = 0.6931471805599453;
+		double bitsPerKey = -std::log(fpRate) / (ln2*ln2);
+		d_k = (unsigned)( bitsPerKey*ln2 + 0.5 );
+		if( d_k < 1 ) 
+			d_k = 1;
+		else if( d_k > 16 ) 
+			d_k = 16;
+		d_numBlocks = (size_t)( expectedKeys * bitsPerKey * 1.2 / BLOCK_BITS ) + 1;
+		d_bits.assign( d_numBlocks*BLOCK_WORDS, 0 );
+		d_numKeys = 0;
+		d_capacity = expectedKeys;
+		d_fpRate = fpRate;
+	}
+	/// zeroes the bits, keeps the size
+	void clear() 
+	{
+		std::fill( d_bits.begin(), d_bits.end(), 0 );
+		d_numKeys = 0;
+	}
+	/// frees the memory. mayContain is always true afterwards
+	void release()
+	{
+		std::vector< uint64_t >().swap( d_bits );
+		d_numBlocks = 0;
+		d_numKeys = 0;
+		d_capacity = 0;
+	}
+
+	void add( uint64_t h )
+	{
+		if( !d_numBlocks ) 
+			return;
+		uint64_t* b = const_cast<uint64_t*>( block(h) );
+		uint64_t x = mix(h);
+		for( unsigned i = 0; i< d_k; ++i ) {
+			if( i && !(i%7) ) // 7 9-bit positions per 64 bits
+				x = mix( x + i );
+			unsigned bit = x & (BLOCK_BITS-1);
+			x >>= 9;
+			b[ bit>>6 ] |= ( (uint64_t)1 << (bit&63) );
+		}
+		++d_numKeys;
+	}
+	/// false - h was never added. true - it probably was
+	bool mayContain( uint64_t h ) const
+	{
+		if( !d_numBlocks ) 
+			return true;
+		const uint64_t* b = block(h);
+		uint64_t x = mix(h);
+		for( unsigned i = 0; i< d_k; ++i ) {
+			if( i && !(i%7) ) 
+				x = mix( x + i );
+			unsigned bit = x & (BLOCK_BITS-1);
+			x >>= 9;
+			if( !( b[ bit>>6 ] & ( (uint64_t)1 << (bit&63) ) ) ) 
+				return false;
+		}
+		return true;
+	}
+
+	bool isInitialized() const { return d_numBlocks; }
+	/// more keys were added than the filter was sized for - false positive rate is going up
+	bool isOverCapacity() const { return d_numKeys > d_capacity; }
+	size_t getNumKeys() const { return d_numKeys; }
+	size_t getCapacity() const { return d_capacity; }
+	double getFpRate() const { return d_fpRate; }
+	unsigned getNumHashes() const { return d_k; }
+	size_t getMemoryUsage() const { return d_bits.capacity()*sizeof(uint64_t); }
+};
+
+} // namespace yay
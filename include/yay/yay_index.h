@@ -25,10 +25,104 @@ THE SOFTWARE.
 #pragma once 
 #include <vector>
 #include <map>
+#include <string>
 #include <algorithm>
+#include <stdint.h>
+#include <queue>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <iostream>
+#include <yay/yay_sort_parallel.h>
+#include <yay/yay_mmap.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 namespace yay {
 
+/// range predicate over a block of values: bit i of the result is set if l <= v[i] <= r. n <= 64
+/// generic version is a scalar loop (branchless, the compiler can vectorize it)
+template <typename T>
+struct index_range_mask {
+    static inline uint64_t get( const T* v, size_t n, const T& l, const T& r )
+    {
+        uint64_t m = 0;
+        for( size_t i = 0; i< n; ++i ) 
+            m |= (uint64_t)( (l <= v[i]) & (v[i] <= r) ) << i;
+        return m;
+    }
+};
+#ifdef __SSE2__
+/// ordered compares - a NaN is never in range, same as in the generic version
+template <>
+struct index_range_mask<double> {
+    static inline uint64_t get( const double* v, size_t n, const double& l, const double& r )
+    {
+        const __m128d lo = _mm_set1_pd( l ), hi = _mm_set1_pd( r );
+        uint64_t m = 0;
+        size_t i = 0;
+        for( ; i+2 <= n; i+= 2 ) {
+            __m128d x = _mm_loadu_pd( v+i );
+            m |= (uint64_t)_mm_movemask_pd( _mm_and_pd( _mm_cmpge_pd(x,lo), _mm_cmple_pd(x,hi) ) ) << i;
+        }
+        for( ; i< n; ++i ) 
+            m |= (uint64_t)( (l <= v[i]) & (v[i] <= r) ) << i;
+        return m;
+    }
+};
+template <>
+struct index_range_mask<float> {
+    static inline uint64_t get( const float* v, size_t n, const float& l, const float& r )
+    {
+        const __m128 lo = _mm_set1_ps( l ), hi = _mm_set1_ps( r );
+        uint64_t m = 0;
+        size_t i = 0;
+        for( ; i+4 <= n; i+= 4 ) {
+            __m128 x = _mm_loadu_ps( v+i );
+            m |= (uint64_t)_mm_movemask_ps( _mm_and_ps( _mm_cmpge_ps(x,lo), _mm_cmple_ps(x,hi) ) ) << i;
+        }
+        for( ; i< n; ++i ) 
+            m |= (uint64_t)( (l <= v[i]) & (v[i] <= r) ) << i;
+        return m;
+    }
+};
+/// 32 bit ints - unsigned values are flipped into the signed range (sse2 only compares signed)
+template <typename I, uint32_t FLIP>
+struct index_range_mask_int32 {
+    static inline uint64_t get( const I* v, size_t n, const I& l, const I& r )
+    {
+        const __m128i flip = _mm_set1_epi32( FLIP );
+        const __m128i lo = _mm_set1_epi32( (int32_t)( (uint32_t)l ^ FLIP ) ), hi = _mm_set1_epi32( (int32_t)( (uint32_t)r ^ FLIP ) );
+        uint64_t m = 0;
+        size_t i = 0;
+        for( ; i+4 <= n; i+= 4 ) {
+            __m128i x = _mm_xor_si128( _mm_loadu_si128( (const __m128i*)(v+i) ), flip );
+            __m128i out = _mm_or_si128( _mm_cmpgt_epi32(lo,x), _mm_cmpgt_epi32(x,hi) );
+            m |= (uint64_t)( ~_mm_movemask_ps( _mm_castsi128_ps(out) ) & 0xf ) << i;
+        }
+        for( ; i< n; ++i ) 
+            m |= (uint64_t)( (l <= v[i]) & (v[i] <= r) ) << i;
+        return m;
+    }
+};
+template <> struct index_range_mask<int32_t> : public index_range_mask_int32<int32_t,0> {};
+template <> struct index_range_mask<uint32_t> : public index_range_mask_int32<uint32_t,0x80000000> {};
+#endif // __SSE2__
+
 /// for every value theres a set of docIds
+/// pairs are stored once, ordered by docId, as two columns - docIds and values. per document checks 
+/// binary search the docId column only, batch filters (filterInRange) walk both columns once, testing 
+/// values 64 at a time (index_range_mask). value order (iterateValue) is a uint32 permutation of 
+/// the rows. when every doc 0..n-1 has exactly one value the docId column is dropped - row is the docId
+///
+/// append+sort is the bulk load. incremental updates (add/remove) go to a small delta layer instead: 
+/// added pairs are kept in a docId ordered map next to the main columns, removed docs are tombstones that 
+/// hide their main rows. queries consult both layers. compact() merges the delta into the main 
+/// columns in one linear pass (no resort), it runs by itself once the delta outgrows getMaxDelta()
+///
+/// a sorted index with plain data T can be written with serialize() and later mapped with load(path) 
+/// and queried in place. updates to a mapped index work too (the delta layer is in memory), 
+/// compact/append/sort copy the image into memory first
 template <typename T>
 class IdValIndex {
 public:
@@ -55,32 +149,341 @@ public:
         }
     };
 
-    // MUST BE SORTED in ascending order
-    std::vector< ValIdPair_t > d_vec;     // sorted using compare_less
-    std::vector< ValIdPair_t > d_vecById; // same pairs as d_vec except sorted by id (compare_less_byid)
+    typedef std::multimap< uint32_t, T > DeltaMap;
+private:
+    /// rows sorted by compare_less_byid. a doc with several values takes several consecutive 
+    /// rows (values ascending). d_colId is empty when the index is dense
+    /// every change to the vectors below is followed by pointAtVectors()
+    std::vector< uint32_t > d_colId;
+    std::vector< T >        d_colVal;
+    /// rows in compare_less order - d_byVal[k] is the row of the k-th smallest pair
+    std::vector< uint32_t > d_byVal;
+    bool d_dense;
+
+    DeltaMap d_delta;                   // docId -> value, added since the last compaction
+    std::vector< uint32_t >    d_tomb;  // docs whose main rows are deleted, sorted
+    size_t d_maxDelta;                  // 0 - automatic
+
+    /// all queries go through these - they point either into the vectors above or into an 
+    /// attached binary image (see attach/load)
+    const uint32_t* d_id;
+    const T*        d_val;
+    const uint32_t* d_perm;
+    size_t          d_numRows;
+    bool            d_attached;
+    std::shared_ptr<mmap_file> d_mmap; // set when the image was loaded from file
+
+    /// d_numRows counts sorted rows only - rows appended since the last sort() have no 
+    /// place in d_byVal yet, queries see the rows as of the last sort()
+    void pointAtVectors()
+    {
+        d_numRows = d_byVal.size();
+        d_id = d_colId.data();
+        d_val = d_colVal.data();
+        d_perm = d_byVal.data();
+        d_attached = false;
+    }
+    /// copies an attached image into the vectors so that it can be modified
+    void materialize()
+    {
+        if( !d_attached ) 
+            return;
+        d_colId.assign( d_id, d_id + ( d_dense ? 0 : d_numRows ) );
+        d_colVal.assign( d_val, d_val + d_numRows );
+        d_byVal.assign( d_perm, d_perm + d_numRows );
+        d_mmap.reset();
+        pointAtVectors();
+    }
+    static const char* imageMagic() { return "YAYIDXV"; }
+    enum { IMAGE_VERSION = 1 };
+
+    uint32_t rowId( size_t i ) const { return ( d_dense ? (uint32_t)i : d_id[i] ); }
+
+    /// first row >= docId, starting from row i. gallops so that a pass over sparse 
+    /// candidates doesnt visit every row
+    size_t seekRow( size_t i, uint32_t docId ) const
+    {
+        const size_t n = d_numRows;
+        if( d_dense ) 
+            return std::max( i, std::min( (size_t)docId, n ) );
+        if( i >= n || !(d_id[i] < docId) ) 
+            return i;
+        size_t lo = i, step = 1;
+        while( lo+step < n && d_id[lo+step] < docId ) {
+            lo += step;
+            step <<= 1;
+        }
+        size_t hi = std::min( lo+step, n );
+        return std::lower_bound( d_id+lo+1, d_id+hi, docId ) - d_id;
+    }
+    struct compare_row_less {
+        const IdValIndex& idx;
+        compare_row_less( const IdValIndex& x ) : idx(x) {}
+        bool operator()( uint32_t row, const T& v ) const { return idx.d_val[row] < v; }
+    };
+public:
+    IdValIndex() : d_dense(false), d_maxDelta(0) { pointAtVectors(); }
 
+    IdValIndex( const IdValIndex& o ) : 
+        d_colId(o.d_colId), d_colVal(o.d_colVal), d_byVal(o.d_byVal), d_dense(o.d_dense), 
+        d_delta(o.d_delta), d_tomb(o.d_tomb), d_maxDelta(o.d_maxDelta), 
+        d_id(o.d_id), d_val(o.d_val), d_perm(o.d_perm), d_numRows(o.d_numRows), d_attached(o.d_attached), 
+        d_mmap(o.d_mmap)
+    { if( !d_attached ) pointAtVectors(); }
 
+    IdValIndex& operator=( const IdValIndex& o ) 
+    {
+        if( this != &o ) {
+            d_colId = o.d_colId;
+            d_colVal = o.d_colVal;
+            d_byVal = o.d_byVal;
+            d_dense = o.d_dense;
+            d_delta = o.d_delta;
+            d_tomb = o.d_tomb;
+            d_maxDelta = o.d_maxDelta;
+            d_id = o.d_id;
+            d_val = o.d_val;
+            d_perm = o.d_perm;
+            d_numRows = o.d_numRows;
+            d_attached = o.d_attached;
+            d_mmap = o.d_mmap;
+            if( !d_attached ) pointAtVectors();
+        }
+        return *this;
+    }
+private:
+    bool isDeleted( uint32_t docId ) const
+        { return ( !d_tomb.empty() && std::binary_search( d_tomb.begin(), d_tomb.end(), docId ) ); }
+
+    /// drops deleted docs from the main layer results in out[from..] and merges in the delta 
+    /// results (ascending, unique)
+    void mergeDelta( std::vector< uint32_t >& out, size_t from, const std::vector< uint32_t >& deltaHits ) const
+    {
+        std::vector< uint32_t > res;
+        res.reserve( out.size()-from + deltaHits.size() );
+        auto t = d_tomb.begin();
+        size_t d = 0;
+        for( size_t i = from; i< out.size(); ++i ) {
+            uint32_t docId = out[i];
+            while( t != d_tomb.end() && *t < docId ) 
+                ++t;
+            if( t != d_tomb.end() && *t == docId ) 
+                continue;
+            for( ; d< deltaHits.size() && deltaHits[d] < docId; ++d ) 
+                res.push_back( deltaHits[d] );
+            if( d< deltaHits.size() && deltaHits[d] == docId ) 
+                ++d;
+            res.push_back( docId );
+        }
+        res.insert( res.end(), deltaHits.begin()+d, deltaHits.end() );
+        out.resize( from );
+        out.insert( out.end(), res.begin(), res.end() );
+    }
+    /// k-way merge of runs[r][from[r]..] into rows ob..oe
+    void mergeRuns( const std::vector< std::vector< ValIdPair_t > >& runs, const std::vector< size_t >& from, size_t ob, size_t oe )
+    {
+        typedef std::pair< const ValIdPair_t*, const ValIdPair_t* > Cursor; // current, end
+        auto greater = []( const Cursor& a, const Cursor& b ) { return compare_less_byid()( *(b.first), *(a.first) ); };
+        std::priority_queue< Cursor, std::vector< Cursor >, decltype(greater) > heap( greater );
+        for( size_t r = 0; r< runs.size(); ++r ) {
+            if( from[r] < runs[r].size() ) 
+                heap.push( Cursor( &(runs[r][from[r]]), &(runs[r][0]) + runs[r].size() ) );
+        }
+        for( size_t i = ob; i< oe; ++i ) {
+            Cursor c = heap.top();
+            heap.pop();
+            d_colId[i] = c.first->second;
+            d_colVal[i] = c.first->first;
+            if( ++c.first != c.second ) 
+                heap.push( c );
+        }
+    }
+    /// columns are in docId order - drops the id column if dense and sorts the value permutation
+    void buildValueOrder( size_t numThreads )
+    {
+        if( !d_dense ) {
+            d_dense = true;
+            for( size_t i = 0; i< d_colId.size() && d_dense; ++i ) 
+                d_dense = ( d_colId[i] == i );
+            if( d_dense ) 
+                std::vector< uint32_t >().swap( d_colId );
+            d_colId.shrink_to_fit();
+            d_colVal.shrink_to_fit();
+        }
+        d_byVal.resize( d_colVal.size() );
+        for( size_t i = 0; i< d_byVal.size(); ++i ) 
+            d_byVal[i] = i;
+        // rows are in docId order so for equal values the row order is the docId order
+        const std::vector< T >& val = d_colVal;
+        parallel_sort( d_byVal.begin(), d_byVal.end(), [&val]( uint32_t a, uint32_t b ) { 
+            return ( val[a] < val[b] ? true : ( val[b] < val[a] ? false : a < b ) );
+        }, numThreads );
+        pointAtVectors();
+    }
+    void maybeCompact()
+    {
+        if( d_delta.size() + d_tomb.size() > getMaxDelta() ) 
+            compact();
+    }
+
+    bool isOneOfMain( uint32_t docId , const std::vector<T>& val ) const
+    {
+        auto v = val.begin();
+        for( size_t i = seekRow( 0, docId ); i< d_numRows && rowId(i) == docId && v!= val.end(); ) {
+            if( d_val[i] < *v ) 
+                ++i;
+            else if( *v < d_val[i] ) 
+                ++v;
+            else 
+                return true;
+        }
+        return false;
+    }
+    bool isInRangeMain( uint32_t docId, const T& l, const T& r ) const
+    {
+        for( size_t i = seekRow( 0, docId ); i< d_numRows && rowId(i) == docId; ++i ) {
+            if( l <= d_val[i] && d_val[i] <= r ) 
+                return true;
+            if( r < d_val[i] ) 
+                break;
+        }
+        return false;
+    }
+
+    size_t filterMainInRange( const uint32_t* cand, size_t numCand, const T& l, const T& r, std::vector< uint32_t >& out ) const
+    {
+        const size_t n = d_numRows, outSz = out.size();
+        // sparse candidates dont pay for masks of 64 rows - their values are tested one by one
+        const bool useMask = ( numCand*8 >= n );
+        size_t maskBlock = ~(size_t)0;
+        uint64_t mask = 0;
+        if( d_dense ) { // row is the docId
+            for( size_t c = 0; c< numCand && cand[c] < n; ++c ) {
+                uint32_t docId = cand[c];
+                if( c && docId == cand[c-1] ) 
+                    continue;
+                if( useMask ) {
+                    if( (docId>>6) != maskBlock ) {
+                        maskBlock = docId>>6;
+                        size_t b = maskBlock<<6;
+                        mask = index_range_mask<T>::get( &(d_val[b]), std::min( (size_t)64, n-b ), l, r );
+                    }
+                    if( (mask>>(docId&63)) & 1 ) 
+                        out.push_back( docId );
+                } else if( l <= d_val[docId] && d_val[docId] <= r ) 
+                    out.push_back( docId );
+            }
+            return out.size()-outSz;
+        }
+        size_t i = 0;
+        for( size_t c = 0; c< numCand && i< n; ++c ) {
+            uint32_t docId = cand[c];
+            i = seekRow( i, docId );
+            for( ; i< n && rowId(i) == docId; ++i ) {
+                if( !useMask ) {
+                    if( l <= d_val[i] && d_val[i] <= r ) {
+                        out.push_back( docId );
+                        i = seekRow( i, docId+1 );
+                        break;
+                    }
+                    continue;
+                }
+                if( (i>>6) != maskBlock ) {
+                    maskBlock = i>>6;
+                    size_t b = maskBlock<<6;
+                    mask = index_range_mask<T>::get( &(d_val[b]), std::min( (size_t)64, n-b ), l, r );
+                }
+                if( (mask>>(i&63)) & 1 ) {
+                    out.push_back( docId );
+                    i = seekRow( i, docId+1 );
+                    break;
+                }
+            }
+        }
+        return out.size()-outSz;
+    }
+    size_t filterMainBitmapInRange( const uint64_t* candBits, size_t numBits, const T& l, const T& r, std::vector< uint32_t >& out ) const
+    {
+        const size_t n = d_numRows, outSz = out.size();
+        for( size_t b = 0; b< n; b+= 64 ) {
+            for( uint64_t m = index_range_mask<T>::get( &(d_val[b]), std::min( (size_t)64, n-b ), l, r ); m; m &= m-1 ) {
+                uint32_t docId = rowId( b + __builtin_ctzll(m) );
+                if( docId < numBits && ( (candBits[docId>>6]>>(docId&63)) & 1 ) && 
+                    ( out.size() == outSz || out.back() != docId ) 
+                ) 
+                    out.push_back( docId );
+            }
+        }
+        return out.size()-outSz;
+    }
+public:
     // val MUST BE SORTED in ascending order
     bool isOneOf( uint32_t docId , const std::vector<T>& val ) const
     {
-        auto vecIter = d_vec.begin();
-        for( auto v = val.begin(); v != val.end(); ++v ) {
-            ValIdPair_t p({ *v, docId });
-            vecIter = std::lower_bound( vecIter, d_vec.end(), p, compare_less() );
-            if( vecIter == d_vec.end() )
-                return false;
-            if( compare_eq()( *vecIter, p ) )
+        if( !isDeleted(docId) && isOneOfMain( docId, val ) ) 
+            return true;
+        for( auto i = d_delta.lower_bound( docId ); i!= d_delta.end() && i->first == docId; ++i ) {
+            if( std::binary_search( val.begin(), val.end(), i->second ) ) 
                 return true;
         }
-
         return false;
     }
     /// the range is inclusive
     bool isInRange( uint32_t docId, const T& l, const T& r ) const
     {
-        ValIdPair_t p({ l, docId });
-        auto i = std::lower_bound( d_vec.begin(), d_vec.end(), p, compare_less_byid() );
-        return( (i == d_vec.end() || i->second != docId) ?  false : !(r< i->first) );
+        if( !isDeleted(docId) && isInRangeMain( docId, l, r ) ) 
+            return true;
+        for( auto i = d_delta.lower_bound( docId ); i!= d_delta.end() && i->first == docId; ++i ) {
+            if( l <= i->second && i->second <= r ) 
+                return true;
+        }
+        return false;
+    }
+
+    /// batch isInRange. cand - docIds sorted in ascending order (duplicates are ok)
+    /// appends the ones having a value in [l,r] to out (ascending, no duplicates). 
+    /// returns the number of ids appended
+    /// one merged pass over the candidates and the columns
+    size_t filterInRange( const uint32_t* cand, size_t numCand, const T& l, const T& r, std::vector< uint32_t >& out ) const
+    {
+        const size_t outSz = out.size();
+        filterMainInRange( cand, numCand, l, r, out );
+        if( d_delta.empty() && d_tomb.empty() ) 
+            return out.size()-outSz;
+        std::vector< uint32_t > deltaHits;
+        auto d = d_delta.begin();
+        for( size_t c = 0; c< numCand && d!= d_delta.end(); ++c ) {
+            while( d!= d_delta.end() && d->first < cand[c] ) 
+                ++d;
+            for( ; d!= d_delta.end() && d->first == cand[c]; ++d ) {
+                if( l <= d->second && d->second <= r && ( deltaHits.empty() || deltaHits.back() != cand[c] ) ) 
+                    deltaHits.push_back( cand[c] );
+            }
+        }
+        mergeDelta( out, outSz, deltaHits );
+        return out.size()-outSz;
+    }
+    size_t filterInRange( const std::vector< uint32_t >& cand, const T& l, const T& r, std::vector< uint32_t >& out ) const
+        { return ( cand.empty() ? 0 : filterInRange( &(cand[0]), cand.size(), l, r, out ) ); }
+
+    /// candidates as a bitmap - docId is a candidate if bit docId of candBits is set (numBits bits). 
+    /// streams through the whole value column, better than the list version when candidates are dense
+    size_t filterBitmapInRange( const uint64_t* candBits, size_t numBits, const T& l, const T& r, std::vector< uint32_t >& out ) const
+    {
+        const size_t outSz = out.size();
+        filterMainBitmapInRange( candBits, numBits, l, r, out );
+        if( d_delta.empty() && d_tomb.empty() ) 
+            return out.size()-outSz;
+        std::vector< uint32_t > deltaHits;
+        for( auto d = d_delta.begin(); d!= d_delta.end(); ++d ) {
+            uint32_t docId = d->first;
+            if( docId < numBits && ( (candBits[docId>>6]>>(docId&63)) & 1 ) && 
+                l <= d->second && d->second <= r && ( deltaHits.empty() || deltaHits.back() != docId ) 
+            ) 
+                deltaHits.push_back( docId );
+        }
+        mergeDelta( out, outSz, deltaHits );
+        return out.size()-outSz;
     }
     
     // iterates over all pairs in range
@@ -89,30 +492,331 @@ public:
     template <typename CB>
     void iterateValue( const CB& cb, const T&l, const T& r )  const
     {
-        ValIdPair_t p({ l, 0 });
-        for( auto i = std::lower_bound( d_vec.begin(), d_vec.end(), p, compare_less_byid() ); i!= d_vec.end() && !(i->first <l) && !(r< i->first); ++i ) {
-            if( !cb( *i ) ) 
+        std::vector< ValIdPair_t > delta;
+        for( auto d = d_delta.begin(); d!= d_delta.end(); ++d ) {
+            if( l <= d->second && d->second <= r ) 
+                delta.push_back( ValIdPair_t( d->second, d->first ) );
+        }
+        std::sort( delta.begin(), delta.end(), compare_less() );
+        auto d = delta.begin();
+        for( const uint32_t* i = std::lower_bound( d_perm, d_perm+d_numRows, l, compare_row_less(*this) ); i!= d_perm+d_numRows && !(r< d_val[*i]); ++i ) {
+            ValIdPair_t p( d_val[*i], rowId(*i) );
+            if( isDeleted(p.second) || !( l <= p.first && p.first <= r ) ) 
+                continue;
+            for( ; d!= delta.end() && compare_less()( *d, p ); ++d ) {
+                if( !cb( *d ) ) 
+                    return;
+            }
+            if( !cb( p ) ) 
+                return;
+        }
+        for( ; d!= delta.end(); ++d ) {
+            if( !cb( *d ) ) 
                 return;
         }
     }
 
+    /// incremental update - goes to the delta layer
+    void add( uint32_t docId, const T& val )
+    {
+        d_delta.insert( typename DeltaMap::value_type( docId, val ) );
+        maybeCompact();
+    }
+    /// removes all values of docId. returns false if the doc wasn't there
+    bool remove( uint32_t docId )
+    {
+        bool found = d_delta.erase( docId );
+
+        size_t i = seekRow( 0, docId );
+        if( i< d_numRows && rowId(i) == docId ) {
+            auto t = std::lower_bound( d_tomb.begin(), d_tomb.end(), docId );
+            if( t == d_tomb.end() || *t != docId ) {
+                d_tomb.insert( t, docId );
+                found = true;
+            }
+        }
+        maybeCompact();
+        return found;
+    }
+    /// merges the delta layer into the main columns. O(N + D log D) - main rows are already sorted 
+    /// both by docId and by value, only the delta gets sorted
+    void compact()
+    {
+        if( !isSorted() ) 
+            sort();
+        if( d_delta.empty() && d_tomb.empty() ) 
+            return;
+        std::vector< ValIdPair_t > delta;
+        delta.reserve( d_delta.size() );
+        for( auto d = d_delta.begin(); d!= d_delta.end(); ++d ) 
+            delta.push_back( ValIdPair_t( d->second, d->first ) );
+        std::sort( delta.begin(), delta.end(), compare_less_byid() );
+
+        const size_t n = d_numRows, numDelta = delta.size();
+        std::vector< uint32_t > newId;
+        std::vector< T > newVal;
+        newId.reserve( n + numDelta );
+        newVal.reserve( n + numDelta );
+        std::vector< uint32_t > newRow( n ), deltaRow( numDelta ); // old main row / delta entry -> new row
+        const uint32_t DELETED = 0xffffffff;
+
+        auto t = d_tomb.begin();
+        size_t i = 0, d = 0;
+        while( i< n || d< numDelta ) {
+            if( i< n && ( d == numDelta || !compare_less_byid()( delta[d], ValIdPair_t( d_val[i], rowId(i) ) ) ) ) {
+                uint32_t docId = rowId(i);
+                while( t != d_tomb.end() && *t < docId ) 
+                    ++t;
+                if( t != d_tomb.end() && *t == docId ) {
+                    newRow[i] = DELETED;
+                } else {
+                    newRow[i] = newId.size();
+                    newId.push_back( docId );
+                    newVal.push_back( d_val[i] );
+                }
+                ++i;
+            } else {
+                deltaRow[d] = newId.size();
+                newId.push_back( delta[d].second );
+                newVal.push_back( delta[d].first );
+                ++d;
+            }
+        }
+
+        // value order - surviving main rows keep their relative order, delta rows are merged in
+        const std::vector< T >& val = newVal;
+        auto valLess = [&val]( uint32_t a, uint32_t b ) { 
+            return ( val[a] < val[b] ? true : ( val[b] < val[a] ? false : a < b ) );
+        };
+        std::sort( deltaRow.begin(), deltaRow.end(), valLess );
+        std::vector< uint32_t > byVal;
+        byVal.reserve( newId.size() );
+        auto dr = deltaRow.begin();
+        for( const uint32_t* k = d_perm; k!= d_perm+n; ++k ) {
+            uint32_t row = newRow[*k];
+            if( row == DELETED ) 
+                continue;
+            for( ; dr != deltaRow.end() && valLess( *dr, row ); ++dr ) 
+                byVal.push_back( *dr );
+            byVal.push_back( row );
+        }
+        byVal.insert( byVal.end(), dr, deltaRow.end() );
+
+        d_dense = true;
+        for( size_t k = 0; k< newId.size() && d_dense; ++k ) 
+            d_dense = ( newId[k] == k );
+        if( d_dense ) 
+            std::vector< uint32_t >().swap( newId );
+        d_colId.swap( newId );
+        d_colVal.swap( newVal );
+        d_byVal.swap( byVal );
+        d_mmap.reset();
+        pointAtVectors();
+        d_delta.clear();
+        std::vector< uint32_t >().swap( d_tomb );
+    }
+    /// delta size (added pairs + tombstones) which triggers compaction. 0 - automatic: 
+    /// 1/32 of the main layer, at least 1024
+    void setMaxDelta( size_t sz ) { d_maxDelta = sz; }
+    size_t getMaxDelta() const 
+        { return ( d_maxDelta ? d_maxDelta : std::max( (size_t)1024, d_numRows/32 ) ); }
+    size_t getDeltaSize() const { return d_delta.size(); }
+    size_t getNumTombstones() const { return d_tomb.size(); }
+
+    /// pairs can be appended in any order, sort() must be called once everything has been loaded 
     void append( uint32_t docId, const T& val ) 
         { 
-            d_vec.push_back({ val, docId }); 
-            d_vecById.push_back({ val, docId }); 
+            materialize();
+            if( d_dense ) { // appending after sort - the id column is needed again
+                d_colId.resize( d_colVal.size() );
+                for( size_t i = 0; i< d_colId.size(); ++i ) 
+                    d_colId[i] = i;
+                d_dense = false;
+            }
+            d_colId.push_back( docId ); 
+            d_colVal.push_back( val ); 
+            pointAtVectors();
         }
 
     /// must be called once everything has been loaded 
-    void sort() { 
-        std::sort( d_vec.begin(), d_vec.end(), compare_less() ); 
-        std::sort( d_vecById.begin(), d_vecById.end(), compare_less_byid() ); 
+    /// numThreads > 1 - both orders are sorted with parallel_sort (0 - hardware concurrency)
+    void sort( size_t numThreads = 1 ) { 
+        materialize();
+        if( !d_dense ) {
+            std::vector< ValIdPair_t > byId( d_colVal.size() );
+            for( size_t i = 0; i< byId.size(); ++i ) 
+                byId[i] = ValIdPair_t( d_colVal[i], d_colId[i] );
+            parallel_sort( byId.begin(), byId.end(), compare_less_byid(), numThreads ); 
+            for( size_t i = 0; i< byId.size(); ++i ) {
+                d_colId[i] = byId[i].second;
+                d_colVal[i] = byId[i].first;
+            }
+        }
+        buildValueOrder( numThreads );
+    }
+    /// bulk load - replaces the contents with the union of runs. every run must be sorted by 
+    /// compare_less_byid (docs in id order, the way loaders usually emit them). runs are k-way 
+    /// merged, with numThreads > 1 every thread merges its own docId range of all runs
+    void bulkLoad( const std::vector< std::vector< ValIdPair_t > >& runs, size_t numThreads = 1 )
+    {
+        clear();
+        size_t n = 0, longest = 0;
+        for( size_t r = 0; r< runs.size(); ++r ) {
+            n += runs[r].size();
+            if( runs[r].size() > runs[longest].size() ) 
+                longest = r;
+        }
+        d_colId.resize( n );
+        d_colVal.resize( n );
+        if( !numThreads ) 
+            numThreads = boost::thread::hardware_concurrency();
+        if( numThreads > n/(64*1024) ) 
+            numThreads = n/(64*1024);
+        if( numThreads < 2 ) {
+            mergeRuns( runs, std::vector< size_t >( runs.size(), 0 ), 0, n );
+        } else {
+            // parts are split at docIds taken from the longest run, part p starts at the first 
+            // pair >= its splitter in every run
+            std::vector< std::vector< size_t > > from( numThreads+1, std::vector< size_t >( runs.size() ) );
+            std::vector< size_t > outFrom( numThreads+1, 0 );
+            for( size_t r = 0; r< runs.size(); ++r ) 
+                from[numThreads][r] = runs[r].size();
+            outFrom[numThreads] = n;
+            for( size_t p = 1; p< numThreads; ++p ) {
+                uint32_t splitter = runs[longest][ runs[longest].size()*p/numThreads ].second;
+                for( size_t r = 0; r< runs.size(); ++r ) {
+                    from[p][r] = std::lower_bound( runs[r].begin(), runs[r].end(), splitter, 
+                        []( const ValIdPair_t& x, uint32_t id ) { return x.second < id; } ) - runs[r].begin();
+                    outFrom[p] += from[p][r];
+                }
+            }
+            worker_exceptions err( numThreads );
+            boost::thread_group threads;
+            for( size_t p = 0; p< numThreads; ++p ) {
+                const std::vector< size_t >* b = &(from[p]);
+                size_t ob = outFrom[p], oe = outFrom[p+1];
+                threads.create_thread( [this,&runs,&err,p,b,ob,oe]() { err.run( p, [&]() { mergeRuns( runs, *b, ob, oe ); } ); } );
+            }
+            threads.join_all();
+            err.rethrow();
+        }
+        buildValueOrder( numThreads );
     }
     void clear() { 
-        d_vec.clear(); 
-        d_vecById.clear(); 
+        d_colId.clear(); 
+        d_colVal.clear(); 
+        d_byVal.clear(); 
+        d_dense = false;
+        d_delta.clear(); 
+        d_tomb.clear(); 
+        d_mmap.reset();
+        pointAtVectors();
+    }
+    /// binary image - header, docId column (absent when dense), value column, value permutation. 
+    /// the image has no pointers in it so it can be mapped at any address. pending updates are 
+    /// compacted into the image (on a copy). the index must be sorted, T must be plain data
+    /// returns 0 on success
+    int serialize( std::ostream& fp ) const
+    {
+        if( !isSorted() ) 
+            return -1;
+        if( !d_delta.empty() || !d_tomb.empty() ) {
+            IdValIndex tmp( *this );
+            tmp.compact();
+            return tmp.serialize( fp );
+        }
+        binary_image_header hdr( imageMagic(), IMAGE_VERSION, sizeof(T), sizeof(uint32_t), d_numRows, ( d_dense ? 0 : d_numRows ) );
+        binary_image_write( fp, &hdr, sizeof(hdr) );
+        binary_image_write( fp, d_id, hdr.numAux*sizeof(uint32_t) );
+        binary_image_write( fp, d_val, d_numRows*sizeof(T) );
+        binary_image_write( fp, d_perm, d_numRows*sizeof(uint32_t) );
+        return ( fp.good() ? 0 : -1 );
+    }
+    /// number of bytes serialize() writes when there are no pending updates
+    size_t getImageSize() const
+    {
+        return ( binary_image_align( sizeof(binary_image_header) ) + 
+            binary_image_align( ( d_dense ? 0 : d_numRows )*sizeof(uint32_t) ) +
+            binary_image_align( d_numRows*sizeof(T) ) + binary_image_align( d_numRows*sizeof(uint32_t) ) );
+    }
+    /// queries will run directly against buf (nothing is copied)
+    /// buf must outlive this object (or be owned by owner) and be aligned at BINARY_IMAGE_ALIGN
+    /// returns 0 on success, -1 if buf isnt a valid image
+    /// only the header and the section bounds are checked - attaching doesnt touch the columns. 
+    /// images from untrusted sources should be checked with verify()
+    int attach( const char* buf, size_t buf_sz, const std::shared_ptr<mmap_file>& owner = std::shared_ptr<mmap_file>() )
+    {
+        clear();
+        if( buf_sz < sizeof(binary_image_header) ) 
+            return -1;
+        const binary_image_header* hdr = (const binary_image_header*)buf;
+        if( !hdr->matches( imageMagic(), IMAGE_VERSION, sizeof(T), sizeof(uint32_t) ) || 
+            ( hdr->numAux && hdr->numAux != hdr->numElem ) 
+        ) 
+            return -1;
+        // sizes are checked before they are multiplied so that a corrupt header cant wrap them
+        if( hdr->numElem > buf_sz/sizeof(T) || hdr->numElem > buf_sz/sizeof(uint32_t) ) 
+            return -1;
+        size_t idOffset = binary_image_align( sizeof(binary_image_header) );
+        size_t valOffset = idOffset + binary_image_align( hdr->numAux*sizeof(uint32_t) );
+        size_t permOffset = valOffset + binary_image_align( hdr->numElem*sizeof(T) );
+        if( permOffset > buf_sz || hdr->numElem*sizeof(uint32_t) > buf_sz - permOffset ) 
+            return -1;
+        d_numRows = hdr->numElem;
+        d_dense = ( d_numRows && !hdr->numAux );
+        d_id = ( hdr->numAux ? (const uint32_t*)(buf+idOffset) : 0 );
+        d_val = (const T*)(buf+valOffset);
+        d_perm = (const uint32_t*)(buf+permOffset);
+        d_attached = true;
+        d_mmap = owner;
+        return 0;
+    }
+    /// maps file written by serialize read only and attaches to it
+    int load( const char* path )
+    {
+        std::shared_ptr<mmap_file> m( new mmap_file );
+        return ( ( m->open(path) || attach( m->data(), m->size(), m ) ) ? -1 : 0 );
+    }
+    /// full check of the main layer (reads all of it) - queries index the values with the 
+    /// permutation and binary search the docId column. returns 0 if queries are safe, -1 otherwise
+    int verify() const
+    {
+        for( size_t k = 0; k< d_numRows; ++k ) {
+            if( d_perm[k] >= d_numRows || ( d_id && k && d_id[k] < d_id[k-1] ) ) 
+                return -1;
+        }
+        return 0;
+    }
+    /// true when queries run against a binary image
+    bool isAttached() const { return d_attached; }
+
+    bool isDense() const { return d_dense; }
+    /// read only views of the main layer (in memory or attached), getNumSortedRows() rows. 
+    /// docId column is 0 when the index is dense (row is the docId)
+    size_t getNumSortedRows() const { return d_numRows; }
+    const uint32_t* getIdColumn() const { return d_id; }
+    const T* getValueColumn() const { return d_val; }
+    /// rows in value order
+    const uint32_t* getValueOrder() const { return d_perm; }
+    /// pending updates
+    const DeltaMap& getDelta() const { return d_delta; }
+    const std::vector< uint32_t >& getTombstones() const { return d_tomb; }
+    /// false when pairs were appended after the last sort()
+    bool isSorted() const { return ( d_attached || d_byVal.size() == d_colVal.size() ); }
+    /// rows in the main layer, including the ones appended but not yet sorted
+    size_t size() const { return std::max( d_numRows, d_colVal.size() ); }
+    /// heap bytes (mapped images arent counted)
+    size_t getMemoryUsage() const 
+    { 
+        return ( d_colId.capacity()*sizeof(uint32_t) + d_colVal.capacity()*sizeof(T) + d_byVal.capacity()*sizeof(uint32_t) + 
+            d_delta.size()*( sizeof(typename DeltaMap::value_type) + 4*sizeof(void*) ) + d_tomb.capacity()*sizeof(uint32_t) ); 
     }
 };
 
+/// binary image (serialize/load) is a directory of properties followed by their IdValIndex images:
+///   header | DirEntry per property | property names | IdValIndex images
+/// loading maps the file and attaches every property to its part of it - nothing is copied or 
+/// rebuilt, so it takes about as long as inserting the property names into the map
 template <typename T>
 struct IdPropValIndex {
 public:
@@ -120,6 +824,16 @@ public:
     typedef typename IdxType_t::ValIdPair_t ValIdPair_t;
 private:
     std::map<std::string, IdxType_t> d_idxMap;
+
+    /// offsets are from the start of the image
+    struct DirEntry {
+        uint64_t nameOffset;
+        uint64_t nameLen;
+        uint64_t idxOffset;
+        uint64_t idxSize;
+    };
+    static const char* imageMagic() { return "YAYPROPI"; }
+    enum { IMAGE_VERSION = 1 };
 public:
     const IdValIndex<T>* getPropIdx( const std::string& propName ) const 
     {
@@ -141,10 +855,154 @@ public:
 
     void append( const std::string& propName, uint32_t docId, const T& val ) 
         { producePropIdx(propName).append( docId, val ); }
-    void sort()
-        { for( auto& i: d_idxMap ) i.second.sort(); }
+    /// incremental updates (see IdValIndex::add)
+    void add( const std::string& propName, uint32_t docId, const T& val ) 
+        { producePropIdx(propName).add( docId, val ); }
+    bool remove( const std::string& propName, uint32_t docId ) 
+    { 
+        IdxType_t* idx = getPropIdx( propName );
+        return ( idx && idx->remove( docId ) );
+    }
+    /// removes the doc from all properties
+    void remove( uint32_t docId )
+        { for( auto& i: d_idxMap ) i.second.remove( docId ); }
+    void compact()
+        { for( auto& i: d_idxMap ) i.second.compact(); }
+    /// numThreads > 1 - properties are sorted concurrently, each thread takes the next unsorted one. 
+    /// properties holding more than 1/numThreads of all pairs are sorted first, one at a time, 
+    /// each with a parallel_sort on all threads. numThreads 0 - hardware concurrency
+    void sort( size_t numThreads = 1 )
+    { 
+        if( !numThreads ) 
+            numThreads = boost::thread::hardware_concurrency();
+        if( numThreads < 2 ) {
+            for( auto& i: d_idxMap ) i.second.sort(); 
+            return;
+        }
+        std::vector< IdxType_t* > small;
+        size_t total = 0;
+        for( auto& i: d_idxMap ) 
+            total += i.second.size();
+        for( auto& i: d_idxMap ) {
+            if( i.second.size()*numThreads > total ) 
+                i.second.sort( numThreads );
+            else 
+                small.push_back( &(i.second) );
+        }
+        // biggest first so that threads finish at about the same time
+        std::sort( small.begin(), small.end(), []( const IdxType_t* a, const IdxType_t* b ) { return a->size() > b->size(); } );
+        std::atomic< size_t > next( 0 );
+        size_t numWorkers = std::min( numThreads, small.size() );
+        worker_exceptions err( numWorkers );
+        boost::thread_group threads;
+        for( size_t t = 0; t< numWorkers; ++t ) {
+            threads.create_thread( [&small,&next,&err,t]() { 
+                err.run( t, [&]() {
+                    for( size_t i; ( i = next.fetch_add(1) ) < small.size(); ) 
+                        small[i]->sort();
+                } );
+            } );
+        }
+        threads.join_all();
+        err.rethrow();
+    }
+    /// see IdValIndex::bulkLoad
+    void bulkLoad( const std::string& propName, const std::vector< std::vector< ValIdPair_t > >& runs, size_t numThreads = 1 )
+        { producePropIdx(propName).bulkLoad( runs, numThreads ); }
     void clear() 
         { for( auto& i: d_idxMap ) i.second.clear(); }
+
+    /// writes the binary image. properties must be sorted. returns 0 on success
+    int serialize( std::ostream& fp ) const
+    {
+        for( auto& i: d_idxMap ) {
+            if( !i.second.isSorted() ) 
+                return -1;
+        }
+        std::deque< IdxType_t > compacted; // copies of properties with pending updates
+        std::vector< const IdxType_t* > idx;
+        for( auto& i: d_idxMap ) {
+            if( i.second.getDeltaSize() || i.second.getNumTombstones() ) {
+                compacted.push_back( i.second );
+                compacted.back().compact();
+                idx.push_back( &(compacted.back()) );
+            } else 
+                idx.push_back( &(i.second) );
+        }
+        std::vector< DirEntry > dir( d_idxMap.size() );
+        size_t namesSz = 0;
+        for( auto& i: d_idxMap ) 
+            namesSz += i.first.length();
+        size_t nameOffset = binary_image_align( sizeof(binary_image_header) ) + binary_image_align( dir.size()*sizeof(DirEntry) );
+        size_t idxOffset = nameOffset + binary_image_align( namesSz );
+        size_t k = 0;
+        for( auto i = d_idxMap.begin(); i!= d_idxMap.end(); ++i, ++k ) {
+            dir[k].nameOffset = nameOffset;
+            dir[k].nameLen = i->first.length();
+            dir[k].idxOffset = idxOffset;
+            dir[k].idxSize = idx[k]->getImageSize();
+            nameOffset += dir[k].nameLen;
+            idxOffset += dir[k].idxSize;
+        }
+
+        binary_image_header hdr( imageMagic(), IMAGE_VERSION, sizeof(T), sizeof(DirEntry), dir.size(), namesSz );
+        binary_image_write( fp, &hdr, sizeof(hdr) );
+        binary_image_write( fp, dir.data(), dir.size()*sizeof(DirEntry) );
+        std::string names;
+        names.reserve( namesSz );
+        for( auto& i: d_idxMap ) 
+            names += i.first;
+        binary_image_write( fp, names.data(), names.size() );
+        for( k = 0; k< idx.size() && fp.good(); ++k ) {
+            if( idx[k]->serialize( fp ) ) 
+                return -1;
+        }
+        return ( fp.good() ? 0 : -1 );
+    }
+    /// replaces all properties with the ones in the image, queries run against buf
+    /// returns 0 on success, -1 if buf isnt a valid image
+    int attach( const char* buf, size_t buf_sz, const std::shared_ptr<mmap_file>& owner = std::shared_ptr<mmap_file>() )
+    {
+        d_idxMap.clear();
+        if( buf_sz < sizeof(binary_image_header) ) 
+            return -1;
+        const binary_image_header* hdr = (const binary_image_header*)buf;
+        const size_t dirOffset = binary_image_align( sizeof(binary_image_header) );
+        if( !hdr->matches( imageMagic(), IMAGE_VERSION, sizeof(T), sizeof(DirEntry) ) || 
+            dirOffset > buf_sz || hdr->numElem > ( buf_sz - dirOffset )/sizeof(DirEntry)
+        ) 
+            return -1;
+        const DirEntry* dir = (const DirEntry*)( buf + dirOffset );
+        for( size_t k = 0; k< hdr->numElem; ++k ) {
+            const DirEntry& e = dir[k];
+            // offset and length are checked separately so that their sum cant wrap
+            if( e.nameOffset > buf_sz || e.nameLen > buf_sz - e.nameOffset || 
+                e.idxOffset > buf_sz || e.idxSize > buf_sz - e.idxOffset || e.idxOffset % BINARY_IMAGE_ALIGN || 
+                producePropIdx( std::string( buf+e.nameOffset, e.nameLen ) ).attach( buf+e.idxOffset, e.idxSize, owner ) 
+            ) {
+                d_idxMap.clear();
+                return -1;
+            }
+        }
+        return 0;
+    }
+    /// maps file written by serialize read only and attaches to it. index pages are shared 
+    /// by all processes mapping the same file
+    int load( const char* path )
+    {
+        std::shared_ptr<mmap_file> m( new mmap_file );
+        return ( ( m->open(path) || attach( m->data(), m->size(), m ) ) ? -1 : 0 );
+    }
+    /// IdValIndex::verify on every property
+    int verify() const
+    {
+        for( auto& i: d_idxMap ) {
+            if( i.second.verify() ) 
+                return -1;
+        }
+        return 0;
+    }
+    size_t getNumProps() const { return d_idxMap.size(); }
 };
 
 
@@ -25,10 +25,25 @@ THE SOFTWARE.
 #pragma once
 
 #include <cmath>
+#include <stdint.h>
 namespace yay {
 
 template <typename T> 
 inline bool epsilon_equals( const T x, const T y, double epsilon ) 
     { return ( 2*fabs(fabs(x)-fabs(y))  < epsilon*(fabs(x)+fabs(y)) ); }
 
+/// high 64 bits of the 128 bit product. mul_hi64( h, n ) maps uniformly distributed h to [0,n) 
+/// without division
+inline uint64_t mul_hi64( uint64_t a, uint64_t b )
+{
+#ifdef __SIZEOF_INT128__
+    return (uint64_t)( ( (unsigned __int128)a * b ) >> 64 );
+#else
+    uint64_t aLo = (uint32_t)a, aHi = a >> 32, bLo = (uint32_t)b, bHi = b >> 32;
+    uint64_t lo = aLo * bLo, mid1 = aHi * bLo, mid2 = aLo * bHi;
+    uint64_t carry = ( ( lo >> 32 ) + (uint32_t)mid1 + (uint32_t)mid2 ) >> 32;
+    return ( aHi * bHi + ( mid1 >> 32 ) + ( mid2 >> 32 ) + carry );
+#endif
+}
+
 }
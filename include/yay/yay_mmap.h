@@ -0,0 +1,97 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_headers.h>
+#include <stdint.h>
+#include <iostream>
+#include <algorithm>
+
+namespace yay {
+
+/// read only memory mapped file
+/// pages are shared by all processes mapping the same file so several workers
+/// loading the same binary image only pay for it once
+class mmap_file {
+	const char* d_buf;
+	size_t      d_sz;
+public:
+	mmap_file(const mmap_file&) = delete;
+	mmap_file& operator=(const mmap_file&) = delete;
+
+	mmap_file() : d_buf(0), d_sz(0) {}
+	~mmap_file() { close(); }
+
+	/// returns 0 on success, -1 if file cant be opened or mapped
+	int open( const char* path );
+	void close();
+
+	bool isOpen() const { return d_buf; }
+	const char* data() const { return d_buf; }
+	size_t size() const { return d_sz; }
+};
+
+/// binary images written by yay containers start with this header
+/// magic identifies the container, version its format. the rest is container specific
+/// typically sizes and counts of the stored arrays
+struct binary_image_header {
+	char     magic[8];
+	uint32_t version;
+	uint32_t elemSz;
+	uint32_t auxSz;
+	uint32_t flags;   // container specific, 0 unless the container says otherwise
+	uint64_t numElem;
+	uint64_t numAux;
+
+	binary_image_header( ) : version(0), elemSz(0), auxSz(0), flags(0), numElem(0), numAux(0) 
+		{ memset( magic, 0, sizeof(magic) ); }
+	binary_image_header( const char* m, uint32_t v, uint32_t esz, uint32_t asz, uint64_t n, uint64_t na=0 ) : 
+		version(v), elemSz(esz), auxSz(asz), flags(0), numElem(n), numAux(na)
+	{ 
+		memset( magic, 0, sizeof(magic) ); 
+		memcpy( magic, m, std::min( strlen(m), sizeof(magic) ) ); 
+	}
+
+	bool matches( const char* m, uint32_t v, uint32_t esz, uint32_t asz ) const 
+		{ return ( !strncmp(magic,m,sizeof(magic)) && version == v && elemSz == esz && auxSz == asz ); }
+};
+
+enum : size_t { BINARY_IMAGE_ALIGN = 8 };
+inline size_t binary_image_align( size_t sz ) 
+	{ return ( (sz + BINARY_IMAGE_ALIGN-1) & ~(size_t)(BINARY_IMAGE_ALIGN-1) ); }
+
+/// writes sz bytes of buf and pads the output to BINARY_IMAGE_ALIGN
+/// returns number of bytes written
+inline size_t binary_image_write( std::ostream& fp, const void* buf, size_t sz )
+{
+	static const char zeroes[BINARY_IMAGE_ALIGN] = {0};
+	if( sz ) 
+		fp.write( (const char*)buf, sz );
+	size_t alignedSz = binary_image_align(sz);
+	if( alignedSz > sz ) 
+		fp.write( zeroes, alignedSz-sz );
+	return alignedSz;
+}
+
+} // namespace yay
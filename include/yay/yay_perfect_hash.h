@@ -0,0 +1,83 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_headers.h>
+#include <yay/yay_math.h>
+#include <vector>
+#include <stdint.h>
+
+namespace yay {
+
+/// perfect hash function over a fixed set of 64 bit key hashes (CHD - compress, hash, displace)
+/// keys are grouped into buckets (about DEFAULT_BUCKET_LOAD keys each), biggest buckets are placed 
+/// first and every bucket gets a pilot - the first displacement at which all its keys land in free 
+/// slots. a lookup is two multiplications and one pilot read. 
+/// slots are 1% more than keys so the last (single key) buckets find a free slot quickly - 
+/// the function is perfect and all but minimal
+///
+/// only hashes are seen here - callers keep whatever the slot maps to and verify the key, 
+/// since a hash that wasnt in the set still lands in some slot
+class perfect_hash {
+	std::vector< uint32_t > d_pilot;
+	size_t d_numSlots;
+
+	static uint64_t mix( uint64_t h )
+	{
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		return ( h ^ (h >> 33) );
+	}
+	/// maps uniformly distributed h to [0,n) without division
+	static size_t range( uint64_t h, size_t n ) 
+		{ return (size_t)mul_hi64( h, n ); }
+
+	size_t bucket( uint64_t h ) const { return range( h, d_pilot.size() ); } // h is expected to be a good hash already
+	size_t slot( uint64_t h, uint32_t pilot ) const 
+		{ return range( mix( h ^ ( (uint64_t)(pilot+1) * 0x9E3779B97F4A7C15ULL ) ), d_numSlots ); }
+public:
+	enum : size_t { DEFAULT_BUCKET_LOAD = 4 };
+
+	perfect_hash() : d_numSlots(0) {}
+
+	/// h[0..n) must be distinct. returns 0 on success, -1 if there are duplicates 
+	/// (or some bucket couldnt be placed, which practically means the same)
+	int build( const uint64_t* h, size_t n );
+	void clear() 
+	{
+		d_pilot.clear();
+		d_numSlots = 0;
+	}
+
+	/// slot of h - always < getNumSlots(). getNumSlots() must not be 0
+	size_t operator()( uint64_t h ) const { return slot( h, d_pilot[ bucket(h) ] ); }
+
+	size_t getNumSlots() const { return d_numSlots; }
+	bool empty() const { return !d_numSlots; }
+	size_t getMemoryUsage() const { return d_pilot.capacity()*sizeof(uint32_t); }
+};
+
+} // namespace yay
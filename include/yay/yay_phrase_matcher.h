@@ -0,0 +1,273 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_trie.h"
+#include "yay/yay_string_pool.h"
+#include "yay/yay_tokenizer.h"
+#include <vector>
+
+namespace yay {
+
+/// true if tok is one of the separator tokens callback_tokenizer emits between words
+inline bool phrase_is_separator_token( const callback_tokenizer& tokenizer, const parse_token& tok )
+{
+	if( !tok.getBuf_sz() ) 
+		return true;
+	if( isascii(tok.getBuf()[0]) ) 
+		return ( tok.getBuf_sz() == 1 && tokenizer.findCharSeparator(tok.getBuf()[0]) == callback_tokenizer::IS_SEPARATOR_YES );
+	int status = callback_tokenizer::IS_SEPARATOR_NO;
+	const char* sepEnd = tokenizer.findUtf8Separator( tok.getBuf(), tok.getBuf()+tok.getBuf_sz(), status );
+	return ( status == callback_tokenizer::IS_SEPARATOR_YES && sepEnd+1 == tok.getBuf()+tok.getBuf_sz() );
+}
+
+/// finds phrases (sequences of token ids stored in a trie<StrId,D>) in a stream of token ids
+/// in one left to right pass. nothing is concatenated - each token id advances every partial match
+/// that is still alive (at most as many as the longest phrase has tokens)
+///
+/// MODE_ALL     - every occurrence of every phrase is reported, including overlapping ones. 
+///                matches are reported as soon as their last token is pushed
+/// MODE_LONGEST - leftmost longest non overlapping matches. a match is reported once no longer 
+///                match starting at the same or earlier token is possible, so reporting may 
+///                lag behind by up to the length of the longest phrase. call flush at the end of the stream
+///
+/// nodes whose data equals noValue are intermediate and never reported
+/// the matcher keeps only a reference to the trie - several matchers (one per stream/thread) can share it
+///     yay::phrase_matcher<uint32_t>::Trie dict;
+///     yay::phrase_matcher<uint32_t>::addPhrase( dict, pool, tokenizer, "new york city", 1, 0 );
+///     yay::phrase_matcher<uint32_t> m( dict, yay::phrase_matcher<uint32_t>::MODE_LONGEST, 0 );
+///     m.scan( tokenizer, pool, text, text_sz, cb );
+template <typename D>
+class phrase_matcher {
+public:
+	typedef UniqueCharPool::StrId StrId;
+	typedef trie< StrId, D > Trie;
+
+	typedef enum {
+		MODE_LONGEST,
+		MODE_ALL
+	} mode_t;
+
+	/// tokens are counted from 0 in the order they were pushed, offsets are whatever was passed to push
+	struct match {
+		size_t tokBegin, tokEnd; // [tokBegin,tokEnd)
+		size_t offBegin, offEnd; // [offBegin,offEnd)
+		const D* data;
+	};
+private:
+	struct state {
+		const Trie* node;    // 0 - can't be extended any more
+		size_t tokBegin, offBegin;
+		const Trie* best;    // longest match so far (MODE_LONGEST only)
+		size_t bestTokEnd, bestOffEnd;
+	};
+	const Trie& d_trie;
+	mode_t      d_mode;
+	D           d_noValue;
+
+	std::vector< state > d_active; // ordered by tokBegin, reused between pushes
+	size_t d_numTok;
+
+	bool isTerminal( const Trie& n ) const { return !(n.data() == d_noValue); }
+
+	template <typename CB>
+	bool report( const state& s, const Trie* n, size_t tokEnd, size_t offEnd, CB& cb ) const
+	{
+		match m;
+		m.tokBegin = s.tokBegin;
+		m.tokEnd = tokEnd;
+		m.offBegin = s.offBegin;
+		m.offEnd = offEnd;
+		m.data = &(n->data());
+		return cb( m );
+	}
+	/// MODE_LONGEST: reports and drops the states at the front that can't grow anymore
+	template <typename CB>
+	bool resolveFront( CB& cb, bool all )
+	{
+		size_t i = 0, i_end = d_active.size();
+		bool rc = true;
+		while( i< i_end && (all || !d_active[i].node) ) {
+			const state& s = d_active[i++];
+			if( s.best ) {
+				if( !report( s, s.best, s.bestTokEnd, s.bestOffEnd, cb ) ) 
+					rc = false;
+				while( i< i_end && d_active[i].tokBegin < s.bestTokEnd ) // overlapping
+					++i;
+				if( !rc ) 
+					break;
+			}
+		}
+		d_active.erase( d_active.begin(), d_active.begin()+i );
+		return rc;
+	}
+public:
+	phrase_matcher( const Trie& t, mode_t mode = MODE_LONGEST, const D& noValue = D() ) : 
+		d_trie(t), d_mode(mode), d_noValue(noValue), d_numTok(0) 
+	{}
+
+	/// forgets partial matches. token numbering starts from 0 again
+	void reset() 
+	{
+		d_active.clear();
+		d_numTok = 0;
+	}
+	size_t getNumTokens() const { return d_numTok; }
+
+	/// CB must have bool operator()( const match& ) - returning false stops the stream
+	/// (push keeps returning false, call reset before reusing the matcher)
+	/// offBegin, offEnd - position of the token in the original text
+	/// id can be ID_NOTFOUND (a word that isn't in the pool) - it breaks every partial match
+	template <typename CB>
+	bool push( StrId id, size_t offBegin, size_t offEnd, CB& cb )
+	{
+		const bool known = ( id != (StrId)UniqueCharPool::ID_NOTFOUND );
+		if( known ) {
+			state ns;
+			ns.node = &d_trie;
+			ns.tokBegin = d_numTok;
+			ns.offBegin = offBegin;
+			ns.best = 0;
+			ns.bestTokEnd = ns.bestOffEnd = 0;
+			d_active.push_back( ns );
+		}
+		++d_numTok;
+
+		bool rc = true;
+		size_t j = 0;
+		for( size_t i = 0, i_end = d_active.size(); i< i_end; ++i ) {
+			state& s = d_active[i];
+			if( s.node ) {
+				typename Trie::VecMap::const_iterator c = ( known ? s.node->find( id ) : s.node->childEnd() );
+				if( c == s.node->childEnd() ) 
+					s.node = 0;
+				else {
+					s.node = &(c->second.get());
+					if( isTerminal(*s.node) ) {
+						if( d_mode == MODE_ALL ) {
+							if( rc && !report( s, s.node, d_numTok, offEnd, cb ) ) 
+								rc = false;
+						} else {
+							s.best = s.node;
+							s.bestTokEnd = d_numTok;
+							s.bestOffEnd = offEnd;
+						}
+					}
+					if( s.node->isLeaf() ) 
+						s.node = 0;
+				}
+			}
+			if( s.node || s.best ) {
+				if( i != j ) 
+					d_active[j] = s;
+				++j;
+			}
+		}
+		d_active.resize( j );
+		if( rc && d_mode == MODE_LONGEST ) 
+			rc = resolveFront( cb, false );
+		return rc;
+	}
+	/// end of stream - reports pending matches (MODE_LONGEST) and resets the matcher
+	template <typename CB>
+	bool flush( CB& cb )
+	{
+		bool rc = ( d_mode == MODE_LONGEST ? resolveFront( cb, true ) : true );
+		reset();
+		return rc;
+	}
+
+	/// tokenizes buf, looks the non separator tokens up in pool and matches them. the pool isn't 
+	/// modified - a word that was never interned (by addPhrase) can't be part of any phrase
+	/// offsets in the reported matches are byte offsets in buf. calls flush at the end
+	/// returns number of tokens pushed
+	template <typename CB>
+	size_t scan( callback_tokenizer& tokenizer, const UniqueCharPool& pool, const char* buf, size_t buf_sz, CB& cb )
+	{
+		push_cb<CB> pcb( *this, tokenizer, pool, cb );
+		size_t numTok = d_numTok;
+		tokenizer.tokenize( buf, buf_sz, pcb );
+		numTok = d_numTok - numTok;
+		if( pcb.rc ) 
+			flush( cb );
+		else
+			reset();
+		return numTok;
+	}
+
+	/// adds phrase to the dictionary. phrase is tokenized by tokenizer the same way scan does it
+	/// returns the node of the last token (t itself if there are no tokens)
+	static Trie& addPhrase( Trie& t, UniqueCharPool& pool, callback_tokenizer& tokenizer, const char* phrase, const D& d, const D& noValue = D() )
+	{
+		add_cb acb( t, tokenizer, pool, noValue );
+		tokenizer.tokenize( phrase, strlen(phrase), acb );
+		acb.node->data() = d;
+		return *(acb.node);
+	}
+	/// adds a phrase given by token ids
+	static Trie& addPhrase( Trie& t, const StrId* ids, size_t ids_sz, const D& d, const D& noValue = D() )
+	{
+		Trie* n = &t;
+		for( size_t i = 0; i< ids_sz; ++i ) 
+			n = &(n->add( ids[i], noValue ));
+		n->data() = d;
+		return *n;
+	}
+private:
+	template <typename CB>
+	struct push_cb {
+		phrase_matcher& m;
+		const callback_tokenizer& tokenizer;
+		const UniqueCharPool& pool;
+		CB& cb;
+		bool rc;
+
+		push_cb( phrase_matcher& pm, const callback_tokenizer& tk, const UniqueCharPool& p, CB& c ) : 
+			m(pm), tokenizer(tk), pool(p), cb(c), rc(true) {}
+		bool operator()( const parse_token& tok )
+		{
+			if( phrase_is_separator_token(tokenizer,tok) ) 
+				return true;
+			StrId id = pool.getId( tok.getBuf(), tok.getBuf_sz() );
+			return ( rc = m.push( id, tok.getOffset(), tok.getOffset()+tok.getBuf_sz(), cb ) );
+		}
+	};
+	struct add_cb {
+		Trie* node;
+		const callback_tokenizer& tokenizer;
+		UniqueCharPool& pool;
+		const D& noValue;
+
+		add_cb( Trie& t, const callback_tokenizer& tk, UniqueCharPool& p, const D& nv ) : 
+			node(&t), tokenizer(tk), pool(p), noValue(nv) {}
+		bool operator()( const parse_token& tok )
+		{
+			if( !phrase_is_separator_token(tokenizer,tok) ) 
+				node = &(node->add( pool.internIt(tok.getBuf(), tok.getBuf_sz()), noValue ));
+			return true;
+		}
+	};
+};
+
+} // namespace yay
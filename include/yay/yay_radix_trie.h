@@ -0,0 +1,244 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_arena.h"
+#include <stdint.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <new>
+#include <type_traits>
+
+namespace yay {
+
+/// edge label of radix_trie - span of bytes (not 0-terminated)
+struct radix_label {
+	const char* buf;
+	uint32_t    buf_sz;
+	char        first; // == buf[0]. kept here so child search doesnt touch the label bytes
+
+	radix_label( const char* b, uint32_t sz ) : buf(b), buf_sz(sz), first(b[0]) {}
+	std::string str() const { return std::string( buf, buf_sz ); }
+};
+inline std::ostream& operator <<( std::ostream& fp, const radix_label& l )
+	{ return fp.write( l.buf, l.buf_sz ); }
+
+/// path compressed (patricia) char trie
+/// every edge is labeled by a span of bytes, so chains of single child nodes of char_trie 
+/// collapse into one edge and a lookup makes one hop per branching point instead of 
+/// one hop per byte
+///
+/// add(s,d,defValue) is the same as in char_trie. nodes created when an edge is split get defValue. 
+/// there are no nodes inside an edge, so lookups are matchWholeEdges(s) - the deepest node whose 
+/// whole path matched and the pointer past it. unlike char_trie::matchString input ending (or 
+/// mismatching) in the middle of an edge doesnt count that edge's bytes as matched
+///
+/// nodes and labels live in a bump_arena owned by the root. VecMap typedefs are provided
+/// so radix_trie can be walked with trie_visitor (Path elements ->first is a radix_label)
+template <typename D>
+class radix_trie {
+public:
+	typedef radix_label key_type;
+	typedef D data_type;
+
+	class child_ref {
+		radix_trie* d_p;
+	public:
+		typedef radix_trie type;
+		explicit child_ref( radix_trie* p ) : d_p(p) {}
+
+		radix_trie& get() { return *d_p; }
+		const radix_trie& get() const { return *d_p; }
+		operator radix_trie& () { return *d_p; }
+		operator const radix_trie& () const { return *d_p; }
+	};
+	typedef std::pair< radix_label, child_ref > value_type;
+
+	struct VecMap {
+		typedef radix_trie::value_type value_type;
+		typedef value_type*            iterator;
+		typedef const value_type*      const_iterator;
+		typedef child_ref              data_type;
+		typedef radix_label            key_type;
+	};
+	typedef std::vector< typename VecMap::iterator > Path;
+private:
+	D           d_data;
+	value_type* d_child;       // sorted by label.first. no two labels start with the same byte
+	uint32_t    d_numChildren;
+	uint32_t    d_capacity;
+	bump_arena* d_arena;
+	bool        d_ownsArena;   // true for the root only
+
+	radix_trie( const D& d, bump_arena* a ) : 
+		d_data(d), d_child(0), d_numChildren(0), d_capacity(0), d_arena(a), d_ownsArena(false) 
+	{}
+
+	static const bool TRIVIAL = std::is_trivially_destructible<D>::value;
+
+	void destroyChildren()
+	{
+		for( value_type* i = d_child, *i_end = d_child+d_numChildren; i!= i_end; ++i ) 
+			i->second.get().~radix_trie();
+	}
+	radix_trie* newNode( const D& d )
+		{ return new (d_arena->alloc( sizeof(radix_trie), alignof(radix_trie) )) radix_trie( d, d_arena ); }
+
+	value_type* findEdge( char c ) 
+	{
+		value_type* i = d_child, *i_end = d_child+d_numChildren;
+		while( i_end - i > 8 ) { // wide node (root typically)
+			value_type* mid = i + (i_end-i)/2;
+			if( c < mid->first.first ) 
+				i_end = mid;
+			else 
+				i = mid;
+		}
+		for( ; i!= i_end && i->first.first < c; ++i ) ;
+		return ( (i != i_end && i->first.first == c) ? i : 0 );
+	}
+	const value_type* findEdge( char c ) const
+		{ return const_cast<radix_trie*>(this)->findEdge(c); }
+
+	void insertEdge( const radix_label& l, radix_trie* child )
+	{
+		if( d_numChildren == d_capacity ) {
+			uint32_t newCap = ( d_capacity ? 2*d_capacity : 2 );
+			value_type* newChild = d_arena->template allocArray<value_type>( newCap );
+			for( uint32_t i = 0; i< d_numChildren; ++i ) 
+				new (newChild+i) value_type( d_child[i] );
+			d_child = newChild;
+			d_capacity = newCap;
+		}
+		uint32_t pos = d_numChildren;
+		for( ; pos && l.first < d_child[pos-1].first.first; --pos ) 
+			new (d_child+pos) value_type( d_child[pos-1] );
+		new (d_child+pos) value_type( l, child_ref(child) );
+		++d_numChildren;
+	}
+public:
+	radix_trie(const radix_trie&) = delete;
+	radix_trie& operator=(const radix_trie&) = delete;
+
+	radix_trie( size_t arenaChunkSz = bump_arena::DEFAULT_CHUNK_SIZE ) : 
+		d_data(), d_child(0), d_numChildren(0), d_capacity(0), d_arena( new bump_arena(arenaChunkSz) ), d_ownsArena(true)
+	{}
+	~radix_trie()
+	{
+		if( !TRIVIAL ) 
+			destroyChildren();
+		if( d_ownsArena ) 
+			delete d_arena;
+	}
+	void clear()
+	{
+		if( !TRIVIAL ) 
+			destroyChildren();
+		d_child = 0;
+		d_numChildren = d_capacity = 0;
+		if( d_ownsArena ) 
+			d_arena->clear();
+	}
+	const bump_arena& getArena() const { return *d_arena; }
+
+	size_t getNumChildren() const { return d_numChildren; }
+	bool isLeaf() const { return !d_numChildren; }
+
+	typename VecMap::const_iterator childBegin() const { return d_child; }
+	typename VecMap::iterator childBegin() { return d_child; }
+	typename VecMap::const_iterator childEnd() const { return d_child+d_numChildren; }
+	typename VecMap::iterator childEnd() { return d_child+d_numChildren; }
+
+	data_type& data() { return d_data; }
+	const data_type& data() const { return d_data; }
+
+	/// same as char_trie::add. returns the node s ends at
+	radix_trie& add( const char* s, const D& d, const D& defValue = D() )
+	{
+		radix_trie* n = this;
+		while( *s ) {
+			value_type* e = n->findEdge( *s );
+			if( !e ) { // rest of s becomes a new leaf
+				size_t len = strlen(s);
+				char* buf = d_arena->template allocArray<char>( len );
+				memcpy( buf, s, len );
+				radix_trie* leaf = newNode( d );
+				n->insertEdge( radix_label(buf,len), leaf );
+				return *leaf;
+			}
+			radix_label& l = e->first;
+			uint32_t common = 1;
+			for( ; common < l.buf_sz && s[common] == l.buf[common]; ++common ) ;
+			if( common < l.buf_sz ) { // edge is split at common
+				radix_trie* mid = newNode( defValue );
+				mid->insertEdge( radix_label(l.buf+common, l.buf_sz-common), &(e->second.get()) );
+				l.buf_sz = common;
+				e->second = child_ref( mid );
+			}
+			n = &(e->second.get());
+			s += common;
+		}
+		n->data() = d;
+		return *n;
+	}
+	/// deepest node whose whole path is a prefix of s and the pointer past that prefix
+	std::pair<const radix_trie*, const char*> matchWholeEdges( const char* s ) const
+	{
+		const radix_trie* found = 0;
+		for( const radix_trie* n = this; *s; ) {
+			const value_type* e = n->findEdge( *s );
+			if( !e ) 
+				break;
+			const radix_label& l = e->first;
+			uint32_t i = 1;
+			for( ; i < l.buf_sz && s[i] == l.buf[i]; ++i ) ;
+			if( i < l.buf_sz ) 
+				break;
+			found = n = &(e->second.get());
+			s += i;
+		}
+		return std::pair<const radix_trie*, const char*>( found, s );
+	}
+	/// same for non 0-terminated s 
+	std::pair<const radix_trie*, const char*> matchWholeEdges( const char* s, size_t s_sz ) const
+	{
+		const radix_trie* found = 0;
+		const char* s_end = s+s_sz;
+		for( const radix_trie* n = this; s< s_end; ) {
+			const value_type* e = n->findEdge( *s );
+			if( !e ) 
+				break;
+			const radix_label& l = e->first;
+			if( (size_t)(s_end-s) < l.buf_sz || memcmp( s, l.buf, l.buf_sz ) ) 
+				break;
+			found = n = &(e->second.get());
+			s += l.buf_sz;
+		}
+		return std::pair<const radix_trie*, const char*>( found, s );
+	}
+};
+
+} // namespace yay
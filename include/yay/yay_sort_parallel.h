@@ -0,0 +1,110 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <exception>
+#include <type_traits>
+
+namespace yay {
+
+/// exceptions thrown on worker threads - every worker catches into its own slot, the thread 
+/// that started them rethrows the first one after join_all (an exception escaping a 
+/// boost::thread would terminate the process)
+class worker_exceptions {
+	std::vector< std::exception_ptr > d_err;
+public:
+	worker_exceptions( size_t numWorkers ) : d_err( numWorkers ) {}
+
+	/// runs f() on behalf of worker w
+	template <typename F>
+	void run( size_t w, F f )
+	{
+		try {
+			f();
+		} catch( ... ) {
+			d_err[w] = std::current_exception();
+		}
+	}
+	void rethrow() const
+	{
+		for( size_t w = 0; w< d_err.size(); ++w ) {
+			if( d_err[w] ) 
+				std::rethrow_exception( d_err[w] );
+		}
+	}
+};
+
+/// std::sort on several threads
+/// the range is split into numThreads contiguous parts, the parts are sorted in parallel and then 
+/// neighbours are merged pairwise (std::inplace_merge, also in parallel). not stable
+/// numThreads 0 - hardware concurrency. ranges under 64K elements per thread use fewer threads
+/// a worker exception (bad_alloc, a throwing comp) is rethrown here, the range is then left unsorted
+/// (integral Comp is ruled out so that parallel_sort( b, e, 4 ) picks the numThreads overload)
+template <typename RI, typename Comp>
+typename std::enable_if< !std::is_integral<Comp>::value >::type 
+parallel_sort( RI begin, RI end, Comp comp, size_t numThreads = 0 )
+{
+	if( !numThreads ) 
+		numThreads = boost::thread::hardware_concurrency();
+	size_t sz = std::distance( begin, end );
+	if( numThreads > sz/(64*1024) ) // not worth a thread
+		numThreads = sz/(64*1024);
+	if( numThreads < 2 ) {
+		std::sort( begin, end, comp );
+		return;
+	}
+
+	std::vector< RI > bound( numThreads+1 );
+	for( size_t s = 0; s<= numThreads; ++s ) 
+		bound[s] = begin + sz*s/numThreads;
+	worker_exceptions err( numThreads );
+	{
+		boost::thread_group threads;
+		for( size_t s = 0; s< numThreads; ++s ) {
+			RI b = bound[s], e = bound[s+1];
+			threads.create_thread( [&err,s,b,e,comp]() { err.run( s, [&]() { std::sort( b, e, comp ); } ); } );
+		}
+		threads.join_all();
+		err.rethrow();
+	}
+	// part s absorbs part s+step
+	for( size_t step = 1; step < numThreads; step *= 2 ) {
+		boost::thread_group threads;
+		for( size_t s = 0; s+step < numThreads; s += 2*step ) {
+			RI b = bound[s], m = bound[s+step], e = bound[ std::min( s+2*step, numThreads ) ];
+			threads.create_thread( [&err,s,b,m,e,comp]() { err.run( s, [&]() { std::inplace_merge( b, m, e, comp ); } ); } );
+		}
+		threads.join_all();
+		err.rethrow();
+	}
+}
+template <typename RI>
+void parallel_sort( RI begin, RI end, size_t numThreads = 0 )
+	{ parallel_sort( begin, end, std::less< typename std::iterator_traits<RI>::value_type >(), numThreads ); }
+
+} // namespace yay
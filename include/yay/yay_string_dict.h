@@ -0,0 +1,146 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_util_char.h>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace yay {
+
+/// sorted, read only string dictionary with front coding
+/// strings are sorted (byte-wise, same as memcmp) and split into buckets of bucketSz. the first string
+/// of a bucket (head) is stored in full, every other one as the length of the prefix it shares with
+/// the previous string plus the remaining suffix. vocabularies with lots of shared prefixes 
+/// (urls, product names) take a fraction of what CharPool needs
+///
+/// ids are ranks in the sorted order, so a prefix maps to a contiguous id range
+///     yay::FrontCodedStringDict d;
+///     d.build( words );
+///     std::pair<uint32_t,uint32_t> r = d.prefixRange( "http://a" ); // [r.first,r.second)
+///     d.forEach( r.first, r.second, []( uint32_t id, const std::string& s ) { ...; return true; } );
+/// string -> id is a binary search over bucket heads and a scan of one bucket, id -> string decodes 
+/// at most bucketSz entries
+class FrontCodedStringDict {
+public:
+	typedef uint32_t StrId;
+	enum : uint32_t { ID_NOTFOUND = 0xffffffff };
+	enum : size_t { DEFAULT_BUCKET_SZ = 16 };
+private:
+	std::vector< uint8_t >  d_data;   // buckets. head: varint len, bytes. rest: varint lcp, varint suffix len, suffix bytes
+	std::vector< uint64_t > d_bucket; // offset of every bucket in d_data
+	size_t d_bucketSz;
+	size_t d_numStrings;
+
+	char_span getHead( size_t b, const uint8_t*& next ) const;
+	/// first bucket whose head is > s (0 - all heads are greater)
+	size_t upperBucket( const char_span& s ) const;
+public:
+	FrontCodedStringDict( size_t bucketSz = DEFAULT_BUCKET_SZ );
+
+	/// strings can come in any order, duplicates are dropped
+	void build( const std::vector< char_span >& strs );
+	void build( const std::vector< std::string >& strs );
+	void clear();
+
+	size_t size() const { return d_numStrings; }
+	bool empty() const { return !d_numStrings; }
+	size_t getBucketSz() const { return d_bucketSz; }
+	/// bytes used by the encoded data and the bucket index
+	size_t getMemoryUsage() const 
+		{ return ( d_data.capacity() + d_bucket.capacity()*sizeof(uint64_t) ); }
+
+	/// returns false if id is out of range
+	bool decode( StrId id, std::string& s ) const;
+	std::string decode( StrId id ) const
+	{
+		std::string s;
+		decode( id, s );
+		return s;
+	}
+	/// ID_NOTFOUND if s isnt in the dictionary
+	StrId getId( const char_span& s ) const;
+	/// id of the first string not less than s (size() if there's none)
+	StrId lowerBound( const char_span& s ) const;
+	/// ids of all strings starting with prefix - [first,second). empty range if there are none
+	std::pair< StrId, StrId > prefixRange( const char_span& prefix ) const;
+
+	/// decodes ids [first,last) sequentially (cheaper than decode for every id)
+	/// CB must have bool operator()( StrId id, const std::string& s ), returning false stops iteration
+	template <typename CB>
+	void forEach( StrId first, StrId last, CB cb ) const;
+};
+
+namespace frontcoded {
+
+inline const uint8_t* readVarint( const uint8_t* p, uint64_t& v )
+{
+	v = 0;
+	for( int shift = 0; ; shift += 7 ) {
+		uint8_t b = *p++;
+		v |= (uint64_t)(b & 0x7f) << shift;
+		if( !(b & 0x80) ) 
+			return p;
+	}
+}
+inline void writeVarint( std::vector<uint8_t>& out, uint64_t v )
+{
+	for( ; v >= 0x80; v >>= 7 ) 
+		out.push_back( (uint8_t)(v | 0x80) );
+	out.push_back( (uint8_t)v );
+}
+
+} // namespace frontcoded 
+
+template <typename CB>
+void FrontCodedStringDict::forEach( StrId first, StrId last, CB cb ) const
+{
+	if( last > d_numStrings ) 
+		last = d_numStrings;
+	if( first >= last ) 
+		return;
+	std::string s;
+	size_t b = first / d_bucketSz;
+	StrId id = b*d_bucketSz;
+	const uint8_t* p = 0;
+	while( id < last ) {
+		if( id % d_bucketSz == 0 ) {
+			char_span h = getHead( id/d_bucketSz, p );
+			s.assign( h.data(), h.size() );
+		} else {
+			uint64_t lcp, sufLen;
+			p = frontcoded::readVarint( p, lcp );
+			p = frontcoded::readVarint( p, sufLen );
+			s.resize( lcp );
+			s.append( (const char*)p, sufLen );
+			p += sufLen;
+		}
+		if( id >= first && !cb( id, s ) ) 
+			return;
+		++id;
+	}
+}
+
+} // namespace yay
@@ -26,7 +26,12 @@ THE SOFTWARE.
 /// alllocation pool functionality 
 #include <yay/yay_headers.h>
 #include <vector>
+#include <algorithm>
+#include <iostream>
 #include <yay/yay_util_char.h>
+#include <yay/yay_perfect_hash.h>
+#include <yay/yay_utf8.h>
+#include <yay/yay_bloom.h>
 #include <stdint.h>
 #include <boost/unordered_map.hpp>
 
@@ -34,15 +39,43 @@ namespace yay {
 
 
 //// pools const char* strings. uniqueness is not enforced  
+/// 
+/// by default clear() frees all memory. with POOL_ARENA the pool keeps its chunks and clear() only 
+/// rewinds the cursor, so a per request scratch pool stops calling malloc once it has seen its 
+/// biggest request (see getHighWater). arena chunks aren't zero filled - nothing in the pool
+/// relies on that, strings are always copied with their terminal 0
+/// POOL_HUGE_PAGES backs chunks with 2MB pages (MAP_HUGETLB, or transparent huge pages when 
+/// none are reserved), chunk size is rounded up to 2MB
 class CharPool {
-	size_t chunkCapacity; // current chunk capacity
-	size_t chunkSz;       // current chunk size
+public:
+	enum : int {
+		POOL_ARENA      = 1,
+		POOL_HUGE_PAGES = 2
+	};
+private:
+	size_t chunkCapacity; // capacity of new chunks
+	size_t chunkSz;       // bytes used in the current chunk
 
 	/// chunks can be of different sizes 
-	typedef std::vector< char* > ChunkVec;
+	struct Chunk {
+		char*  buf;
+		size_t capacity;
+		bool   isMmapped;
+	};
+	typedef std::vector< Chunk > ChunkVec;
 	ChunkVec chunk;	
+	size_t curChunk;      // chunk being filled. chunks after it are only there in arena mode (kept from before clear)
+	int    flags;
+
+	size_t bytesUsed;     // handed out since last clear
+	size_t highWater;     // max bytesUsed ever
+	size_t bytesReserved; // total capacity of all chunks
+
+	Chunk allocChunk( size_t sz ) const;
+	void freeChunk( Chunk& c ) const;
 protected:
 	char* addNewChunk( ) ;
+	char* allocInPool( size_t len ) { return (char*)alloc( len, 1 ); }
 public:
     CharPool(const CharPool&) = delete;
 	CharPool& operator=(const CharPool&) = delete;
@@ -52,11 +85,25 @@ public:
 	// pushes new string into the pool 
 	const char* addStringToPool( const char* s )
 		{return( s ? addStringToPool(s,strlen(s)+1) : "" ); }
+	// copies len bytes of s (no terminal 0 expected) and terminates the copy
+	const char* addSpanToPool( const char* s, size_t len );
+
+	/// raw memory from the pool. align must be a power of 2
+	void* alloc( size_t sz, size_t align = sizeof(void*) );
 		
 	enum { DEFAULT_CHUNK_SIZE = 64*1024 };
-	CharPool( size_t cSz = DEFAULT_CHUNK_SIZE );
+	CharPool( size_t cSz = DEFAULT_CHUNK_SIZE, int poolFlags = 0 );
+	/// frees everything (POOL_ARENA - rewinds and keeps the chunks)
 	void clear();
+	/// frees everything regardless of the mode
+	void release();
 	~CharPool();
+
+	bool isArena() const { return ( flags & POOL_ARENA ); }
+	size_t getNumChunks() const { return chunk.size(); }
+	size_t getBytesUsed() const { return bytesUsed; }
+	size_t getHighWater() const { return highWater; }
+	size_t getBytesReserved() const { return bytesReserved; }
 };
 
 /// default string serializer (escapes newlines)
@@ -81,8 +128,9 @@ struct StringSerializer {
     {
         size_t sz = 0;
         fp >> sz;
-        if( sz > buf.size() ) 
-            sz = buf.size();
+        fp.get(); // space between the length and the string
+        if( sz >= buf.size() ) 
+            sz = buf.size()-1;
         if( !fp.read( &(buf[0]), sz+1 ) )  // +1 to account for the trailing newline
             return false;
         s.assign( &(buf[0]), sz );
@@ -99,6 +147,17 @@ struct StringSerializer {
 
 /// stores each string only once 
 /// also issues "string ids" - 4-byte integers
+/// strings are looked up by pointer + length (char_span) so non terminated input (tokenizer output)
+/// is neither copied nor rescanned. every string is hashed once - the hash is kept in the 
+/// index slot and reused when the index grows. lengths are stored by id
+///
+/// once the vocabulary stops changing freeze() replaces the index with a perfect hash: getId is then 
+/// one hash, one pilot read, one slot read and (unless the slot hash rejects it) a single compare 
+/// against the string the slot points to. interning a new string into a frozen pool thaws it 
+/// (the regular index is rebuilt)
+///
+/// when most lookups are misses (unknown words) enableBloomFilter() puts a blocked bloom filter in 
+/// front of the index - getId then rejects most misses with one cache line read and no probing
 class UniqueCharPool : public CharPool {
 public:
 	typedef uint32_t StrId;
@@ -106,13 +165,91 @@ public:
 	enum { 
 		ID_NOTFOUND = 0xffffffff 
 	};
-	// typedef std::map< char_cp, StrId, yay::char_cp_compare_less > CharIdMap;
+	/// pool flag (along with CharPool ones). strings differing only in case get the same id - 
+	/// the id resolves to the first variant interned. folding is unicode simple case folding (tableU2L)
+	/// done on the fly, no folded copies are made
+	enum : int {
+		POOL_CASE_FOLD = 0x100
+	};
+	/// kept for getCharIdMap callers - the pool itself doesnt use a map anymore
 	typedef boost::unordered_map< char_cp, StrId, char_cp_hash, yay::char_cp_compare_eq > CharIdMap;
 private:
+	/// open addressing index, linear probing. id ID_NOTFOUND - empty slot
+	struct IdSlot {
+		StrId    id;
+		uint32_t hash;
+	};
+	typedef std::vector< IdSlot > IdSlotVec;
+	/// perfect hash slot. the pooled string is kept in the slot itself so that a lookup doesnt 
+	/// go through idVec/idLen - this buys back the extra pilot read of the perfect hash
+	struct FrozenSlot {
+		const char* str; // 0 for unused slots
+		StrId       id;
+		uint32_t    hash;
+	};
+	typedef std::vector< FrozenSlot > FrozenSlotVec;
+
 	char_cp_vec idVec; // idVec[StrId] is the char_cp
-	CharIdMap idMap;
-	// map_by_char_cp<StrId>::Type idMap; // idMap[char_cp] returns id 
+	std::vector< uint32_t > idLen; // idLen[StrId] is the length of the string (without terminal 0)
+	IdSlotVec idSlot;
 		// ID_NOTFOUND when string cant be found
+
+	perfect_hash mph;                // frozen only
+	FrozenSlotVec mphSlot;           // mphSlot[ mph(hash) ] - string, id (ID_NOTFOUND for unused slots) and slotHash to reject misses without touching the string
+	bool frozen;
+
+	bool caseFold;
+
+	blocked_bloom_filter bloom; // empty unless enableBloomFilter was called
+
+	/// resizes the filter for capacity keys and adds all pooled strings
+	void rebuildBloomFilter( size_t capacity, double fpRate );
+
+	uint64_t keyHash( const char* s, size_t s_len ) const
+		{ return ( caseFold ? utf8_casefold::hash( s, s_len ) : char_span_hash()( s, s_len ) ); }
+	static uint32_t slotHash( uint64_t h ) { return (uint32_t)( h ^ (h>>32) ); }
+	uint32_t slotHash( const char* s, size_t s_len ) const { return slotHash( keyHash(s,s_len) ); }
+	bool keyEq( StrId id, const char* s, size_t s_len ) const
+	{
+		return ( caseFold ? 
+			utf8_casefold::equal( idVec[id], idLen[id], s, s_len ) : 
+			( idLen[id] == s_len && !memcmp(idVec[id],s,s_len) ) );
+	}
+	/// the string is read through the slot, the length comes from idLen (pooled strings can have 0s in them)
+	bool frozenKeyEq( const FrozenSlot& slot, const char* s, size_t s_len ) const
+	{
+		if( caseFold ) 
+			return keyEq( slot.id, s, s_len );
+		return ( idLen[slot.id] == s_len && !memcmp( slot.str, s, s_len ) );
+	}
+	size_t findSlot( const char* s, size_t s_len, uint32_t h ) const
+	{
+		size_t mask = idSlot.size()-1;
+		for( size_t i = h & mask; ; i = (i+1) & mask ) {
+			const IdSlot& slot = idSlot[i];
+			if( slot.id == ID_NOTFOUND || 
+				( slot.hash == h && keyEq(slot.id,s,s_len) ) 
+			)
+				return i;
+		}
+	}
+	/// load factor is kept at or under .5. nothing is rehashed - slots carry the hash
+	void growIndex()
+	{
+		IdSlotVec old( idSlot.size() ? idSlot.size()*2 : 16 );
+		IdSlot empty = { ID_NOTFOUND, 0 };
+		std::fill( old.begin(), old.end(), empty );
+		old.swap( idSlot );
+		size_t mask = idSlot.size()-1;
+		for( IdSlotVec::const_iterator i = old.begin(); i!= old.end(); ++i ) {
+			if( i->id == ID_NOTFOUND ) 
+				continue;
+			size_t j = i->hash & mask;
+			while( idSlot[j].id != ID_NOTFOUND ) 
+				j = (j+1) & mask;
+			idSlot[j] = *i;
+		}
+	}
 public: 
     template <typename SRLZR>
     int serialize( SRLZR& srlzr, std::ostream& fp )  const
@@ -132,7 +269,7 @@ public:
 
         std::string s;
         for( size_t i=0; i< sz && srlzr(s,fp); ++i )
-            internIt(s.c_str());
+            internIt(s.c_str(),s.length());
         return 0;
     }
     int deserialize( std::istream& fp )
@@ -145,20 +282,57 @@ public:
         StringSerializer srlzr;
         return serialize( srlzr, fp );
     }
-    const CharIdMap& getCharIdMap() const { return idMap; }
 	void clear() 
 	{
-		idMap.clear();
+		frozen = false;
+		mph.clear();
+		mphSlot.clear();
+		idSlot.clear();
 		idVec.clear();
+		idLen.clear();
+		bloom.clear();
 		CharPool::clear();
 	}
-	StrId getId( const char* s ) const
+	/// s doesnt have to be 0 terminated
+	StrId getId( const char* s, size_t s_len ) const
 		{ 
-			CharIdMap::const_iterator i= idMap.find(s);
-			return ( i == idMap.end() ? ID_NOTFOUND : i->second );
+			uint64_t h = keyHash( s, s_len );
+			if( !bloom.mayContain(h) ) 
+				return ID_NOTFOUND;
+			if( frozen ) {
+				if( mph.empty() ) 
+					return ID_NOTFOUND;
+				const FrozenSlot& slot = mphSlot[ mph(h) ];
+				return ( ( slot.hash == slotHash(h) && slot.str && frozenKeyEq(slot,s,s_len) ) ? 
+					slot.id : (StrId)ID_NOTFOUND );
+			}
+			if( idSlot.empty() ) 
+				return ID_NOTFOUND;
+			return idSlot[ findSlot(s,s_len,slotHash(h)) ].id;
 		}
+	StrId getId( const char_span& s ) const
+		{ return getId( s.data(), s.size() ); }
+	StrId getId( const char* s ) const
+		{ return ( s ? getId(s,strlen(s)) : (StrId)ID_NOTFOUND ); }
+
 	const char* resolveId( uint32_t id ) const
 		{ return ( (id< idVec.size()) ? idVec[id] : 0 ); }
+	/// length of the string without the terminating 0 (0 for unknown ids)
+	size_t getLength( uint32_t id ) const
+		{ return ( (id< idLen.size()) ? idLen[id] : 0 ); }
+	char_span resolveSpan( uint32_t id ) const
+		{ return ( (id< idVec.size()) ? char_span(idVec[id],idLen[id]) : char_span() ); }
+	/// string -> id map built from the pool. used to be a reference to the pool's own index, now 
+	/// it's a copy made on each call (O(n)) - callers should cache it or use getId. keys are the 
+	/// pooled strings as 0 terminated char_cp (so strings with 0s in them are cut) and compare 
+	/// case sensitively even for POOL_CASE_FOLD pools
+	CharIdMap getCharIdMap() const
+	{
+		CharIdMap m( idVec.size() );
+		for( StrId id = 0; id< idVec.size(); ++id ) 
+			m.insert( CharIdMap::value_type(idVec[id], id) );
+		return m;
+	}
 	
 	// this is guaranteed to never return 0
 	inline const char* printableStr(uint32_t id) const
@@ -167,46 +341,65 @@ public:
 			return( s? s: ""); 
 		}
 				
-	inline StrId internIt( const char* s )
-    {
-        
-	    StrId id = getId(s);
-	    if( id!=ID_NOTFOUND ) {
-		    return id;
-	    }	
-	    const char * newS = addStringToPool( s );
-	    id = idVec.size();
-	    idVec.push_back( newS );
-	    idMap.insert( CharIdMap::value_type(newS, id) );
-	
-	    return id;
-    }
-    std::string d_junkBuf;
-
+	/// s doesnt have to be 0 terminated - the pooled copy always is
 	inline StrId internIt( const char* s, size_t s_len )
     {
-        if( !s[s_len] ) 
-            return internIt(s);
-        else {
-            d_junkBuf.assign(s,s_len);
-	        StrId id = getId(d_junkBuf.c_str());
-	        if( id!=ID_NOTFOUND ) {
-		        return id;
-	        }	
-	        const char * newS = addStringToPool( s, s_len );
-	        id = idVec.size();
-	        idVec.push_back( newS );
-	        idMap.insert( CharIdMap::value_type(newS, id) );
-        	
-	        return id;
+        if( frozen ) {
+            StrId id = getId( s, s_len );
+            if( id != ID_NOTFOUND ) 
+                return id;
+            thaw();
         }
+        if( 2*(idVec.size()+1) > idSlot.size() ) 
+            growIndex();
+        uint64_t kh = keyHash(s,s_len);
+        uint32_t h = slotHash(kh);
+        IdSlot& slot = idSlot[ findSlot(s,s_len,h) ];
+        if( slot.id != ID_NOTFOUND ) 
+            return slot.id;
+
+        StrId id = idVec.size();
+        slot.id = id;
+        slot.hash = h;
+        idVec.push_back( addSpanToPool(s,s_len) );
+        idLen.push_back( s_len );
+        if( bloom.isInitialized() ) {
+            bloom.add( kh );
+            if( bloom.isOverCapacity() ) 
+                rebuildBloomFilter( 2*bloom.getCapacity(), bloom.getFpRate() );
+        }
+        return id;
     }
-	UniqueCharPool( size_t cSz = DEFAULT_CHUNK_SIZE ) : 
-		CharPool(cSz ) { }
+	inline StrId internIt( const char_span& s )
+		{ return internIt( s.data(), s.size() ); }
+	inline StrId internIt( const char* s )
+		{ return internIt( s, strlen(s) ); }
 
-    size_t getMaxId() const { return idVec.size(); }
-    
+	/// builds the perfect hash and releases the regular index. returns 0 on success, 
+	/// -1 if the perfect hash couldnt be built (pool stays as it was)
+	int freeze();
+	/// back to the regular index 
+	void thaw();
+	bool isFrozen() const { return frozen; }
+	/// bytes used by the lookup structures (not the strings)
+	size_t getIndexMemoryUsage() const 
+		{ return ( idSlot.capacity()*sizeof(IdSlot) + mph.getMemoryUsage() + mphSlot.capacity()*sizeof(FrozenSlot) + bloom.getMemoryUsage() ); }
+
+	/// getId consults a bloom filter with fpRate false positives before touching the index. 
+	/// expectedKeys - initial size (the filter is rebuilt twice as big whenever the pool outgrows it). 
+	/// works with frozen and case folding pools
+	void enableBloomFilter( double fpRate = 0.01, size_t expectedKeys = 0 )
+		{ rebuildBloomFilter( std::max( expectedKeys, 2*idVec.size() ), fpRate ); }
+	void disableBloomFilter() { bloom.release(); }
+	bool hasBloomFilter() const { return bloom.isInitialized(); }
+	const blocked_bloom_filter& getBloomFilter() const { return bloom; }
+
+	bool isCaseFold() const { return caseFold; }
 
+	UniqueCharPool( size_t cSz = DEFAULT_CHUNK_SIZE, int poolFlags = 0 ) : 
+		CharPool(cSz, poolFlags ), frozen(false), caseFold( poolFlags & POOL_CASE_FOLD ) { }
+
+    size_t getMaxId() const { return idVec.size(); }
 };
 
 } // namespace yay
@@ -0,0 +1,133 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_string_pool.h>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <boost/unordered_map.hpp>
+
+namespace yay {
+
+/// thread safe UniqueCharPool
+/// strings are spread over hash shards, each shard has its own lock, map and CharPool so threads 
+/// interning different strings rarely touch the same lock. ids are global, dense (0,1,2...) and never 
+/// change once issued (though ids issued concurrently can come in any order)
+///
+/// resolveId is wait-free - the id -> string directory is a fixed array of chunk pointers, chunks 
+/// are published with atomic stores and never move, so readers don't lock anything
+///
+/// getMaxId() can briefly be ahead of what's published - resolveId returns 0 for an id that's being 
+/// interned at this very moment by another thread. an id returned by internIt/getId is always resolvable
+class ConcurrentUniqueCharPool {
+public:
+	typedef UniqueCharPool::StrId StrId;
+
+	/// pointer + length with its hash (char_span_hash) - the hash that picked the shard is reused 
+	/// by the shard map. input doesnt have to be 0 terminated
+	struct HashedStr {
+		char_cp  str;
+		size_t   len;
+		uint64_t hash;
+
+		HashedStr( char_cp s, size_t l ) : str(s), len(l), hash( char_span_hash()(s,l) ) {}
+		HashedStr( char_cp s, size_t l, uint64_t h ) : str(s), len(l), hash(h) {}
+	};
+	struct HashedStrHash {
+		size_t operator()( const HashedStr& x ) const { return x.hash; }
+	};
+	struct HashedStrEq {
+		bool operator()( const HashedStr& x, const HashedStr& y ) const 
+			{ return ( x.hash == y.hash && x.len == y.len && !memcmp( x.str, y.str, x.len ) ); }
+	};
+	typedef boost::unordered_map< HashedStr, StrId, HashedStrHash, HashedStrEq > CharIdMap;
+
+	enum : uint32_t { 
+		ID_NOTFOUND = UniqueCharPool::ID_NOTFOUND 
+	};
+	enum : size_t { 
+		DEFAULT_NUM_SHARDS = 64,
+		DIR_CHUNK_BITS = 16,
+		DIR_CHUNK_SZ = (1<<DIR_CHUNK_BITS),
+		DIR_MAX_CHUNKS = ((size_t)1<<(32-DIR_CHUNK_BITS))
+	};
+private:
+	struct Shard {
+		std::mutex mtx;
+		CharIdMap  idMap;
+		CharPool   pool;
+		char       pad[64]; // keeps locks of neighbouring shards off the same cache line
+
+		Shard( size_t cSz ) : pool(cSz) {}
+	};
+	std::unique_ptr< std::unique_ptr<Shard>[] > d_shard;
+	size_t d_shardMask;
+
+	typedef std::atomic<char_cp> DirEntry;
+	std::unique_ptr< std::atomic<DirEntry*>[] > d_dir; // d_dir[id>>DIR_CHUNK_BITS][id&(DIR_CHUNK_SZ-1)]
+	std::atomic<uint32_t> d_nextId;
+
+	Shard& getShard( uint64_t h ) const
+		{ return *(d_shard[ ( (h * 0x9E3779B97F4A7C15ULL) >> 40 ) & d_shardMask ]); } // map buckets use the low bits
+	DirEntry* getDirChunk( uint32_t id );
+	StrId internInShard( Shard& sh, const HashedStr& key );
+public:
+	ConcurrentUniqueCharPool(const ConcurrentUniqueCharPool&) = delete;
+	ConcurrentUniqueCharPool& operator=(const ConcurrentUniqueCharPool&) = delete;
+
+	/// numShards is rounded up to a power of 2
+	ConcurrentUniqueCharPool( size_t numShards = DEFAULT_NUM_SHARDS, size_t cSz = CharPool::DEFAULT_CHUNK_SIZE );
+	~ConcurrentUniqueCharPool();
+
+	/// thread safe. ID_NOTFOUND once all 2^32-1 ids have been issued
+	/// s doesnt have to be 0 terminated - the pooled copy always is
+	StrId internIt( const char* s, size_t s_len );
+	StrId internIt( const char* s ) 
+		{ return internIt( s, strlen(s) ); }
+	StrId getId( const char* s, size_t s_len ) const;
+	StrId getId( const char* s ) const
+		{ return getId( s, strlen(s) ); }
+
+	/// wait-free. 0 if id isn't (yet) interned
+	const char* resolveId( StrId id ) const
+	{
+		if( id >= ID_NOTFOUND ) 
+			return 0;
+		const DirEntry* chunk = d_dir[ id>>DIR_CHUNK_BITS ].load( std::memory_order_acquire );
+		return ( chunk ? chunk[ id & (DIR_CHUNK_SZ-1) ].load( std::memory_order_acquire ) : 0 );
+	}
+	inline const char* printableStr( StrId id ) const
+	{
+		const char* s = resolveId(id);
+		return( s? s: "" );
+	}
+	size_t getMaxId() const { return d_nextId.load( std::memory_order_acquire ); }
+	size_t getNumShards() const { return d_shardMask+1; }
+
+	/// NOT thread safe - nobody can use the pool while it's being cleared
+	void clear();
+};
+
+} // namespace yay
@@ -0,0 +1,199 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_string_pool.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+
+namespace yay {
+
+/// string interner for long running processes - unlike UniqueCharPool it can shrink
+/// every string belongs to a generation: the one it was last interned (or touched) in. newGeneration() 
+/// opens a new one, retireGenerations(g) forgets all strings not interned since generation g and 
+/// copies the surviving ones out of the old generations' chunks into the current one. old chunks 
+/// are then freed as a whole - under steady churn memory is bounded by what was interned in the 
+/// generations that are kept
+///
+/// ids of forgotten strings are recycled, so an id is only meaningful as long as its string is alive 
+/// (see isAlive). strings move when they are compacted - a const char* obtained from the pool is 
+/// valid while the reader holds a ReadGuard (epoch based reclamation: retired chunks are freed only 
+/// after every reader that entered before the retirement has left). guards can be taken on any thread;
+/// everything else (interning, lookups, retiring) needs the same external locking as UniqueCharPool
+///     yay::GenerationalCharPool pool;
+///     id = pool.internIt( s, len );
+///     ...
+///     pool.advance( 3 ); // every minute or so - keeps strings seen in the last 3 generations
+class GenerationalCharPool {
+public:
+	typedef uint32_t StrId;
+	typedef uint32_t Generation;
+
+	enum : uint32_t { 
+		ID_NOTFOUND = 0xffffffff 
+	};
+	enum : size_t { 
+		MAX_READERS = 64 
+	};
+
+	/// pins the current epoch - strings resolved while the guard is alive won't be freed under it
+	class ReadGuard {
+		const GenerationalCharPool& d_pool;
+		size_t d_slot;
+	public:
+		ReadGuard(const ReadGuard&) = delete;
+		ReadGuard& operator=(const ReadGuard&) = delete;
+
+		ReadGuard( const GenerationalCharPool& p ) : d_pool(p), d_slot(p.enterRead()) {}
+		~ReadGuard() { d_pool.exitRead( d_slot ); }
+	};
+private:
+	/// id directory entry. free entries have str == 0 and keep the next free id in len
+	struct Entry {
+		const char* str;
+		uint32_t    len;
+		Generation  gen;  // generation the string was last interned in
+		Generation  home; // generation whose pool holds the bytes
+	};
+	std::vector< Entry > d_entry;
+	StrId d_freeId; // head of the free id list
+
+	/// open addressing index, linear probing with backward shift deletion. id ID_NOTFOUND - empty slot
+	struct IdSlot {
+		StrId    id;
+		uint32_t hash;
+	};
+	std::vector< IdSlot > d_slot;
+	size_t d_numLive;
+
+	struct GenPool {
+		Generation gen;
+		std::unique_ptr< CharPool > pool;
+	};
+	std::deque< GenPool > d_gen; // oldest first, back() is the current generation
+	size_t d_chunkSz;
+
+	struct RetiredPool {
+		uint64_t epoch;
+		std::unique_ptr< CharPool > pool;
+	};
+	std::vector< RetiredPool > d_retired;
+
+	mutable std::atomic<uint64_t> d_epoch;
+	mutable std::atomic<uint64_t> d_reader[ MAX_READERS ]; // epoch the reader entered in, 0 - free slot
+
+	size_t enterRead() const;
+	void exitRead( size_t slot ) const { d_reader[slot].store( 0, std::memory_order_release ); }
+
+	static uint32_t slotHash( const char* s, size_t s_len )
+	{
+		uint64_t h = char_span_hash()( s, s_len );
+		return (uint32_t)( h ^ (h>>32) );
+	}
+	size_t findSlot( const char* s, size_t s_len, uint32_t h ) const
+	{
+		size_t mask = d_slot.size()-1;
+		for( size_t i = h & mask; ; i = (i+1) & mask ) {
+			const IdSlot& slot = d_slot[i];
+			if( slot.id == ID_NOTFOUND || 
+				( slot.hash == h && d_entry[slot.id].len == s_len && !memcmp(d_entry[slot.id].str,s,s_len) ) 
+			)
+				return i;
+		}
+	}
+	/// sizes the index for d_numLive (load <= .5) and reinserts everything
+	void rebuildIndex();
+	void eraseFromIndex( StrId id );
+	CharPool& curPool() { return *(d_gen.back().pool); }
+public:
+	GenerationalCharPool(const GenerationalCharPool&) = delete;
+	GenerationalCharPool& operator=(const GenerationalCharPool&) = delete;
+
+	GenerationalCharPool( size_t cSz = CharPool::DEFAULT_CHUNK_SIZE );
+	~GenerationalCharPool();
+
+	/// s doesnt have to be 0 terminated. interning an existing string moves it to the current generation
+	StrId internIt( const char* s, size_t s_len );
+	StrId internIt( const char* s )
+		{ return internIt( s, strlen(s) ); }
+	StrId internIt( const char_span& s )
+		{ return internIt( s.data(), s.size() ); }
+
+	/// lookup only - doesnt touch the string's generation
+	StrId getId( const char* s, size_t s_len ) const
+	{
+		if( !d_numLive ) 
+			return ID_NOTFOUND;
+		return d_slot[ findSlot( s, s_len, slotHash(s,s_len) ) ].id;
+	}
+	StrId getId( const char* s ) const
+		{ return ( s ? getId(s,strlen(s)) : (StrId)ID_NOTFOUND ); }
+
+	bool isAlive( StrId id ) const 
+		{ return ( id < d_entry.size() && d_entry[id].str ); }
+	/// 0 for ids that aren't alive
+	const char* resolveId( StrId id ) const
+		{ return ( isAlive(id) ? d_entry[id].str : 0 ); }
+	size_t getLength( StrId id ) const
+		{ return ( isAlive(id) ? d_entry[id].len : 0 ); }
+	char_span resolveSpan( StrId id ) const
+		{ return ( isAlive(id) ? char_span(d_entry[id].str,d_entry[id].len) : char_span() ); }
+	inline const char* printableStr( StrId id ) const
+	{
+		const char* s = resolveId(id);
+		return( s? s: "" );
+	}
+	/// generation the string was last interned in (meaningless for ids that aren't alive)
+	Generation getIdGeneration( StrId id ) const
+		{ return ( isAlive(id) ? d_entry[id].gen : 0 ); }
+
+	Generation getGeneration() const { return d_gen.back().gen; }
+	/// starts a new generation. returns its number
+	Generation newGeneration();
+	/// forgets every string last interned before generation keepFrom, compacts the survivors into 
+	/// the current generation and retires the pools of the older generations. returns number of 
+	/// strings forgotten
+	size_t retireGenerations( Generation keepFrom );
+	/// newGeneration() + retireGenerations() keeping numKeep generations (including the new one)
+	size_t advance( size_t numKeep );
+	/// frees retired pools no reader can see anymore. called by retireGenerations, only needed 
+	/// when readers were holding guards at that time
+	size_t reclaim();
+
+	/// number of live strings
+	size_t size() const { return d_numLive; }
+	/// upper bound for ids (ids are recycled, not all ids under it are alive)
+	size_t getMaxId() const { return d_entry.size(); }
+	size_t getNumGenerations() const { return d_gen.size(); }
+	size_t getNumRetiredPools() const { return d_retired.size(); }
+	/// bytes reserved by string pools (live and retired) plus the index and the directory
+	size_t getMemoryUsage() const;
+
+	/// forgets everything. nobody may hold a ReadGuard
+	void clear();
+};
+
+} // namespace yay
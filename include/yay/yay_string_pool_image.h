@@ -0,0 +1,129 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_string_pool.h>
+#include <yay/yay_mmap.h>
+#include <memory>
+
+namespace yay {
+
+/// read only UniqueCharPool queried directly in a binary image 
+/// the image is written by serialize( const UniqueCharPool&, ... ) and is
+///   header | offsets (numStrings+1 uint64) | hash table (uint32 ids) | blob of 0 terminated strings
+/// nothing is rebuilt when it's loaded - getId probes the stored hash table (open addressing, 
+/// linear probing) and resolveId is blob+offsets[id], so a mapped image of any size is usable right away
+/// ids are the same as in the UniqueCharPool that was written
+///     yay::MappedUniqueCharPool::serialize( pool, fp );
+///     ...
+///     yay::MappedUniqueCharPool mp;
+///     if( mp.load( "vocab.bin" ) ) 
+///         error 
+///     uint32_t id = mp.getId( "hello" ); 
+class MappedUniqueCharPool {
+public:
+	typedef UniqueCharPool::StrId StrId;
+	enum : uint32_t { 
+		ID_NOTFOUND = UniqueCharPool::ID_NOTFOUND,
+		IMAGE_VERSION = 2
+	};
+	/// hash function ids, kept in the header flags (bits 0-7). images with a hash this code 
+	/// doesnt know are rejected by attach
+	enum : uint32_t {
+		HASH_CHAR_SPAN = 1, // char_span_hash - same as UniqueCharPool
+		HASH_ID_MASK = 0xff,
+		IMAGE_CASE_FOLD = 0x100 // written from a POOL_CASE_FOLD pool - hashed and compared folded
+	};
+	static const char* imageMagic() { return "YAYSPOOL"; }
+
+	/// hash used by the image. it works on bytes (no char signedness) so images built 
+	/// on one ABI are valid on another with the same byte order
+	static uint64_t hash( const char* s, size_t s_len )
+		{ return char_span_hash()( s, s_len ); }
+	/// same for case folding pools (utf8_casefold, as UniqueCharPool with POOL_CASE_FOLD)
+	static uint64_t hash( const char* s, size_t s_len, bool caseFold )
+		{ return ( caseFold ? utf8_casefold::hash( s, s_len ) : hash( s, s_len ) ); }
+private:
+	const uint64_t* d_offset;
+	const uint32_t* d_slot;
+	const char*     d_blob;
+	size_t          d_numStrings;
+	size_t          d_slotMask;
+	size_t          d_blobSz;
+	bool            d_caseFold;
+
+	std::shared_ptr<mmap_file> d_mmap; // set when the image was loaded from file
+public:
+	MappedUniqueCharPool() : d_offset(0), d_slot(0), d_blob(0), d_numStrings(0), d_slotMask(0), d_blobSz(0), d_caseFold(false) {}
+
+	/// writes binary image of pool. returns 0 on success
+	static int serialize( const UniqueCharPool& pool, std::ostream& fp );
+
+	/// queries will run directly against buf (nothing is copied)
+	/// buf must outlive this object and be aligned at BINARY_IMAGE_ALIGN
+	/// returns 0 on success, -1 if buf isnt a valid image
+	/// only the header and the section bounds are checked - attaching doesnt touch the rest of 
+	/// the image. images from untrusted sources should be checked with verify()
+	int attach( const char* buf, size_t buf_sz );
+	/// full check of the attached image (reads all of it). returns 0 if lookups are safe, -1 otherwise
+	int verify() const;
+	/// maps file written by serialize read only and attaches to it
+	int load( const char* path );
+	void clear();
+
+	StrId getId( const char* s, size_t s_len ) const
+	{
+		if( !d_numStrings ) 
+			return ID_NOTFOUND;
+		for( size_t i = hash(s,s_len,d_caseFold) & d_slotMask; ; i = ( i+1 ) & d_slotMask ) {
+			StrId id = d_slot[i];
+			if( id == ID_NOTFOUND ) 
+				return ID_NOTFOUND;
+			if( d_caseFold ? 
+				utf8_casefold::equal( d_blob+d_offset[id], getLength(id), s, s_len ) : 
+				( getLength(id) == s_len && !memcmp( d_blob+d_offset[id], s, s_len ) ) 
+			) 
+				return id;
+		}
+	}
+	StrId getId( const char* s ) const
+		{ return getId( s, strlen(s) ); }
+
+	const char* resolveId( StrId id ) const
+		{ return ( id < d_numStrings ? d_blob+d_offset[id] : 0 ); }
+	/// length of the string without the terminating 0. id must be valid
+	size_t getLength( StrId id ) const
+		{ return d_offset[id+1]-d_offset[id]-1; }
+	inline const char* printableStr( StrId id ) const
+	{
+		const char* s = resolveId(id);
+		return( s? s: "" );
+	}
+	size_t getMaxId() const { return d_numStrings; }
+	/// true when the image was written from a POOL_CASE_FOLD pool
+	bool isCaseFold() const { return d_caseFold; }
+	bool empty() const { return !d_numStrings; }
+};
+
+} // namespace yay
@@ -25,6 +25,7 @@ THE SOFTWARE.
 #pragma once
 #include <stdint.h>
 #include <yay/yay_utf8.h>
+#include <yay/yay_bitflags.h>
 #include <ctype.h>
 #include <iostream>
 
@@ -59,7 +59,7 @@ public:
 	typedef std::vector< typename VecMap::iterator > Path;
 
 	trie( const data_type& d ) : d_data(d) {}
-	trie( ) {}
+	trie( ) : d_data() {} // value initialized - merge() reads the root data of default constructed tries
 
 	data_type& data() { return d_data; }
 	const data_type& data() const { return d_data; }
@@ -80,6 +80,48 @@ public:
 		}
 	}
 
+	/// merges o into this trie in time linear in the size of both tries
+	/// o is consumed - its subtrees are moved over and o is left empty
+	/// for every node present in both tries (including the root) data becomes upd( this->data(), o.data() )
+	/// Updater must have data_type operator()( const data_type& mine, const data_type& theirs )
+	template<typename Updater>
+	trie& merge( trie& o, Updater upd )
+	{
+		d_data = upd( d_data, o.d_data );
+		if( o.isLeaf() ) 
+			return *this;
+		if( isLeaf() ) {
+			typename VecMap::TheVec v;
+			o.d_child.swapVector( v );
+			d_child.swapVector( v );
+			return *this;
+		}
+		typename VecMap::TheVec v, mine, theirs;
+		d_child.swapVector( mine );
+		o.d_child.swapVector( theirs );
+		v.reserve( mine.size() + theirs.size() );
+
+		typename VecMap::value_comp less;
+		typename VecMap::iterator i = mine.begin(), j = theirs.begin();
+		while( i != mine.end() && j != theirs.end() ) {
+			if( less(*i,*j) ) 
+				v.push_back( std::move(*i++) );
+			else if( less(*j,*i) ) 
+				v.push_back( std::move(*j++) );
+			else {
+				i->second.get().merge( j->second.get(), upd );
+				v.push_back( std::move(*i++) );
+				++j;
+			}
+		}
+		for( ; i!= mine.end(); ++i ) 
+			v.push_back( std::move(*i) );
+		for( ; j!= theirs.end(); ++j ) 
+			v.push_back( std::move(*j) );
+		d_child.swapVector( v );
+		return *this;
+	}
+
 	typename VecMap::const_iterator find( const  key_type& key ) const 
 		{ return d_child.find( key ); }
 	typename VecMap::iterator find( const  key_type& key ) 
@@ -183,7 +225,7 @@ struct trie_visitor {
 			int cbRc =d_cb( d_stack ) ;
 			switch( cbRc ) {
 			case TRIE_VISITOR_CONTINUE:
-				visit( i->second );
+				visit( i->second.get() );
 				d_stack.pop_back( );
 				break;
 			case TRIE_VISITOR_PRUNE: d_stack.pop_back( ); break;
@@ -195,14 +237,14 @@ struct trie_visitor {
 	bool visit_leaves( trie_type& t )
 	{
 		for( trie_child_iterator i = t.childBegin(); i != t.childEnd(); ++i ) {
-			if( i->second.isLeaf() ) {
+			if( i->second.get().isLeaf() ) {
 				d_stack.push_back( i );
 			
 				int cbRc =d_cb( d_stack ) ;
 				d_stack.pop_back( ); 
 				if( cbRc == TRIE_VISITOR_ABORT ) return false;
 			} else
-				visit_leaves( i->second );
+				visit_leaves( i->second.get() );
 		}
 		return true;
 	}
@@ -0,0 +1,318 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_arena.h"
+#include <stdint.h>
+#include <vector>
+#include <iterator>
+#include <new>
+#include <type_traits>
+
+namespace yay {
+
+/// arena_trie has the same interface as yay::trie but all nodes and all child arrays
+/// are carved out of one bump_arena owned by the root and freed wholesale when the root 
+/// is destroyed. there is no malloc per node and no deep copying of subtrees when 
+/// children are inserted (trie's recursive_wrapper copies whole subtrees when vecmap shifts)
+///
+/// child arrays grow by doubling, abandoned arrays stay in the arena until it's freed
+///
+/// build() constructs the trie from sorted keys in one linear pass - every new child
+/// is appended at the end of its parent's child array
+///
+/// arena_trie mimics trie's VecMap typedefs so trie_visitor, frozen_trie and trie_fuzzy_matcher
+/// work with it unchanged
+template <typename K, typename D, typename Comp=std::less<K> >
+class arena_trie {
+public:
+	typedef K key_type;
+	typedef D data_type;
+
+	/// plays the role of boost::recursive_wrapper in trie - except it's just a pointer
+	class child_ref {
+		arena_trie* d_p;
+	public:
+		typedef arena_trie type;
+		explicit child_ref( arena_trie* p ) : d_p(p) {}
+
+		arena_trie& get() { return *d_p; }
+		const arena_trie& get() const { return *d_p; }
+		operator arena_trie& () { return *d_p; }
+		operator const arena_trie& () const { return *d_p; }
+	};
+	typedef std::pair< K, child_ref > value_type;
+
+	struct VecMap {
+		typedef arena_trie::value_type value_type;
+		typedef value_type*            iterator;
+		typedef const value_type*      const_iterator;
+		typedef child_ref              data_type;
+		typedef K                      key_type;
+	};
+	typedef std::vector< typename VecMap::iterator > Path;
+private:
+	D           d_data;
+	value_type* d_child;
+	uint32_t    d_numChildren;
+	uint32_t    d_capacity;
+	bump_arena* d_arena;
+	bool        d_ownsArena; // true for the root only 
+
+	arena_trie( bump_arena* a, const data_type& d ) : 
+		d_data(d), d_child(0), d_numChildren(0), d_capacity(0), d_arena(a), d_ownsArena(false) 
+	{}
+
+	static const bool TRIVIAL = std::is_trivially_destructible<D>::value && std::is_trivially_destructible<K>::value;
+
+	void destroyChildren()
+	{
+		for( value_type* i = d_child, *i_end = d_child+d_numChildren; i!= i_end; ++i ) {
+			i->second.get().~arena_trie();
+			i->~value_type();
+		}
+	}
+	/// makes sure there's room for one more child
+	void reserveOne()
+	{
+		if( d_numChildren < d_capacity ) 
+			return;
+		uint32_t newCap = ( d_capacity ? 2*d_capacity : 2 );
+		value_type* newChild = d_arena->template allocArray<value_type>( newCap );
+		for( uint32_t i = 0; i< d_numChildren; ++i ) {
+			new (newChild+i) value_type( d_child[i] );
+			if( !TRIVIAL ) d_child[i].~value_type();
+		}
+		d_child = newChild;
+		d_capacity = newCap;
+	}
+	arena_trie& insertAt( size_t pos, const key_type& key, const data_type& d )
+	{
+		reserveOne();
+		arena_trie* n = new (d_arena->alloc( sizeof(arena_trie), alignof(arena_trie) )) arena_trie( d_arena, d );
+		if( pos == d_numChildren ) 
+			new (d_child+pos) value_type( key, child_ref(n) );
+		else {
+			new (d_child+d_numChildren) value_type( d_child[d_numChildren-1] );
+			for( size_t i = d_numChildren-1; i> pos; --i ) 
+				d_child[i] = d_child[i-1];
+			d_child[pos] = value_type( key, child_ref(n) );
+		}
+		++d_numChildren;
+		return *n;
+	}
+	/// adds child assuming key is greater than all existing keys (falls back to add otherwise)
+	arena_trie& append( const key_type& key, const data_type& d )
+	{
+		if( !d_numChildren || Comp()( d_child[d_numChildren-1].first, key ) ) 
+			return insertAt( d_numChildren, key, d );
+		return add( key, d );
+	}
+public:
+	arena_trie(const arena_trie&) = delete;
+	arena_trie& operator=(const arena_trie&) = delete;
+
+	arena_trie( size_t arenaChunkSz = bump_arena::DEFAULT_CHUNK_SIZE ) : 
+		d_data(), d_child(0), d_numChildren(0), d_capacity(0), d_arena( new bump_arena(arenaChunkSz) ), d_ownsArena(true)
+	{}
+	/// root data goes after the chunk size (and has no default) so that a single integer 
+	/// argument is never ambiguous when D is integral
+	arena_trie( size_t arenaChunkSz, const data_type& d ) : 
+		d_data(d), d_child(0), d_numChildren(0), d_capacity(0), d_arena( new bump_arena(arenaChunkSz) ), d_ownsArena(true)
+	{}
+	~arena_trie()
+	{
+		if( !TRIVIAL ) 
+			destroyChildren();
+		if( d_ownsArena ) 
+			delete d_arena;
+	}
+	/// removes all children (root keeps its data). arena memory is released 
+	void clear()
+	{
+		if( !TRIVIAL ) 
+			destroyChildren();
+		d_child = 0;
+		d_numChildren = d_capacity = 0;
+		if( d_ownsArena ) 
+			d_arena->clear();
+	}
+	const bump_arena& getArena() const { return *d_arena; }
+
+	size_t getNumChildren() const { return d_numChildren; }
+	bool isLeaf() const { return !d_numChildren; }
+
+	value_type& operator[]( size_t i ) { return d_child[i]; }
+	const value_type& operator[]( size_t i ) const { return d_child[i]; }
+
+	typename VecMap::const_iterator childBegin() const { return d_child; }
+	typename VecMap::iterator childBegin() { return d_child; }
+	typename VecMap::const_iterator childEnd() const { return d_child+d_numChildren; }
+	typename VecMap::iterator childEnd() { return d_child+d_numChildren; }
+
+	data_type& data() { return d_data; }
+	const data_type& data() const { return d_data; }
+
+	struct value_comp {
+		bool operator() ( const value_type& l, const key_type& r ) const
+			{ return Comp()( l.first, r ); }
+	};
+	typename VecMap::iterator lower_bound( const key_type& key ) 
+		{ return std::lower_bound( childBegin(), childEnd(), key, value_comp() ); }
+	typename VecMap::const_iterator lower_bound( const key_type& key ) const
+		{ return std::lower_bound( childBegin(), childEnd(), key, value_comp() ); }
+
+	typename VecMap::const_iterator find( const key_type& key ) const 
+	{ 
+		typename VecMap::const_iterator i = lower_bound(key); 
+		return ( (i == childEnd() || Comp()(key,i->first)) ? childEnd() : i );
+	}
+	typename VecMap::iterator find( const key_type& key ) 
+	{ 
+		typename VecMap::iterator i = lower_bound(key); 
+		return ( (i == childEnd() || Comp()(key,i->first)) ? childEnd() : i );
+	}
+
+	arena_trie& add( const key_type& key, const data_type& d )
+	{ 
+		typename VecMap::iterator i = lower_bound(key); 
+		if( i != childEnd() && !Comp()(key,i->first) ) 
+			return i->second.get();
+		return insertAt( i-d_child, key, d );
+	}
+
+	template<typename Updater>
+	arena_trie& addWithUpdate(const key_type& key, Updater upd)
+	{
+		typename VecMap::iterator pos = find(key);
+		if (pos == childEnd())
+			return add(key, upd(data_type()));
+		else {
+			pos->second.get().data() = upd(pos->second.get().data());
+			return pos->second.get();
+		}
+	}
+
+	/// same as trie::getLongestPath
+	template <class FI>
+	std::pair< const arena_trie*, FI> getLongestPath( FI start, FI end ) const
+	{
+		const arena_trie* found = 0;
+		for( const arena_trie* n = this; start != end; ++start ) {
+			typename VecMap::const_iterator i = n->find( *start );
+			if( i == n->childEnd() ) 
+				break;
+			found = n = &(i->second.get());
+		}
+		return std::pair< const arena_trie*, FI>( found, start );
+	}
+	/// same as trie::getTerminatedLongestPath
+	template <class FI>
+	std::pair< const arena_trie*, FI> getTerminatedLongestPath( FI start, typename std::iterator_traits<FI>::value_type end ) const
+	{
+		const arena_trie* found = 0;
+		for( const arena_trie* n = this; !(*start == end); ++start ) {
+			typename VecMap::const_iterator i = n->find( *start );
+			if( i == n->childEnd() ) 
+				break;
+			found = n = &(i->second.get());
+		}
+		return std::pair< const arena_trie*, FI>( found, start );
+	}
+
+	/// FI must be an iterator such that *FI is pair<key_type,data_type>
+	template <class FI>
+	arena_trie& addPath( FI start, FI end )
+	{
+		arena_trie* n = this;
+		for( ; start != end; ++start ) 
+			n = &(n->add( start->first, start->second ));
+		return *n;
+	}
+	/// FI must be an iterator such that *FI is key_type
+	template <class FI>
+	arena_trie& addKeyPath( FI start, FI end, const data_type& dfltV = data_type() )
+	{
+		arena_trie* n = this;
+		for( ; start != end; ++start ) 
+			n = &(n->add( *start, dfltV ));
+		return *n;
+	}
+	template <class FI>
+	arena_trie& addTerminatedKeyPath( FI start, typename std::iterator_traits<FI>::value_type stopV, const data_type& dfltV = data_type() )
+	{
+		arena_trie* n = this;
+		for( ; !(*start == stopV); ++start ) 
+			n = &(n->add( *start, dfltV ));
+		return *n;
+	}
+
+	/// bulk load. FI must be a forward iterator over pair<KeySeq,data_type> sorted by key 
+	/// KeySeq must have begin()/end() over key_type (std::string, std::vector<K> ...)
+	/// intermediate nodes get dfltV. 
+	/// keys are compared only to the previous key, so every node is touched once and every 
+	/// child is appended at the end of its parent. out of order keys are still inserted 
+	/// correctly but lose the linear time guarantee
+	template <class FI>
+	void build( FI start, FI end, const data_type& dfltV = data_type() )
+	{
+		std::vector< arena_trie* > path; // path[d] - node at depth d on the previous key's path
+		path.push_back( this );
+		FI prev = end;
+		for( ; start != end; prev = start, ++start ) {
+			typename std::iterator_traits<FI>::value_type::first_type::const_iterator 
+				k = start->first.begin(), k_end = start->first.end();
+			size_t lcp = 0;
+			if( prev != end ) {
+				for( auto p = prev->first.begin(), p_end = prev->first.end(); p != p_end && k != k_end && *p == *k; ++p, ++k ) 
+					++lcp;
+			}
+			path.resize( lcp+1 );
+			arena_trie* n = path.back();
+			for( ; k != k_end; ++k ) {
+				n = &(n->append( *k, dfltV ));
+				path.push_back(n);
+			}
+			n->data() = start->second;
+		}
+	}
+};
+
+/// char trie on arena
+template<typename D>
+class char_arena_trie : public arena_trie<char, D>
+{
+public:
+	typedef arena_trie<char, D> Trie;
+
+	char_arena_trie( size_t arenaChunkSz = bump_arena::DEFAULT_CHUNK_SIZE ) : Trie(arenaChunkSz) {}
+
+	void add(const char *s, const D& d, const D& defValue = D())
+		{ this->addTerminatedKeyPath( s, ((char)0), defValue ).data() = d; }
+	
+	std::pair<const Trie*, const char*> matchString(const char *s) const
+		{ return this->getTerminatedLongestPath( s, (char)(0) ); }
+};
+
+} // namespace yay
@@ -0,0 +1,331 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_trie.h"
+#include "yay/yay_mmap.h"
+#include <stdint.h>
+#include <vector>
+#include <iterator>
+#include <memory>
+#include <new>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace yay {
+
+/// child key search used by frozen_trie. returns pointer to the key equal to key or 0
+/// generic version is a binary search over the packed keys
+template <typename K, typename Comp>
+struct frozen_trie_key_search {
+	static inline const K* find( const K* kb, const K* ke, const K& key )
+	{
+		const K* k = std::lower_bound( kb, ke, key, Comp() );
+		return ( (k == ke || Comp()(key,*k)) ? 0 : k );
+	}
+};
+#ifdef __SSE2__
+/// code point keys (utf8_trie) - alphabets make for wide nodes so the keys are compared 
+/// 4 at a time. very wide nodes are first narrowed down with a binary search
+template <>
+struct frozen_trie_key_search< uint32_t, std::less<uint32_t> > {
+	enum : size_t { LINEAR_SCAN_MAX = 32 };
+	static inline const uint32_t* find( const uint32_t* kb, const uint32_t* ke, const uint32_t& key )
+	{
+		while( (size_t)(ke-kb) > LINEAR_SCAN_MAX ) {
+			const uint32_t* mid = kb + (ke-kb)/2;
+			if( key < *mid ) 
+				ke = mid;
+			else 
+				kb = mid;
+		}
+		const __m128i needle = _mm_set1_epi32( key );
+		for( ; kb+4 <= ke; kb+= 4 ) {
+			__m128i v = _mm_loadu_si128( (const __m128i*)kb );
+			int mask = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32(v,needle) ) );
+			if( mask ) 
+				return kb + __builtin_ctz(mask);
+		}
+		for( ; kb< ke; ++kb ) {
+			if( *kb == key ) 
+				return kb;
+		}
+		return 0;
+	}
+};
+#endif // __SSE2__
+
+/// frozen_trie is a read only copy of a fully built trie
+/// all nodes live in one vector in breadth first order so children of every node
+/// are contiguous: node n has children [n.firstChild, n.firstChild+n.numChildren)
+/// edge keys are kept in a separate packed vector (d_key[i] is the key leading to node i)
+/// so child lookup is a binary search over a few adjacent keys instead of chasing
+/// a heap pointer per node
+///
+/// typical use:
+///     yay::char_trie<uint32_t> t;
+///     ... t.add( ... ) many times
+///     yay::frozen_char_trie<uint32_t> ft( t ); // or ft.freeze(t)
+///     // t is no longer needed and can be destroyed
+///
+/// frozen tries with plain data D can be written with serialize() and later
+/// loaded with load(path) which maps the file and queries it in place
+template <typename K, typename D, typename Comp=std::less<K> >
+class frozen_trie {
+public:
+	typedef K key_type;
+	typedef D data_type;
+	typedef trie<K,D,Comp> trie_type;
+
+	class node {
+		uint32_t d_firstChild;
+		uint32_t d_numChildren;
+		D        d_data;
+
+		friend class frozen_trie;
+	public:
+		node( const D& d ) : d_firstChild(0), d_numChildren(0), d_data(d) {}
+
+		const data_type& data() const { return d_data; }
+		size_t getNumChildren() const { return d_numChildren; }
+		bool isLeaf() const { return !d_numChildren; }
+	};
+private:
+	std::vector< node > d_nodeVec; // d_nodeVec[0] is the root
+	std::vector< K >    d_keyVec;  // d_keyVec[i] is the key of the edge leading to d_nodeVec[i]. d_keyVec[0] is unused
+
+	/// all lookups go through these - they point either into the vectors above 
+	/// or into an attached binary image (see attach/load)
+	const node* d_node;
+	const K*    d_key;
+	size_t      d_numNodes;
+
+	std::shared_ptr<mmap_file> d_mmap; // set when the image was loaded from file
+
+	void pointAtVectors()
+	{
+		d_numNodes = d_nodeVec.size();
+		d_node = ( d_numNodes ? &(d_nodeVec[0]) : 0 );
+		d_key = ( d_numNodes ? &(d_keyVec[0]) : 0 );
+	}
+	static const char* imageMagic() { return "YAYTRIE"; }
+	enum { IMAGE_VERSION = 1 };
+public:
+	frozen_trie() : d_node(0), d_key(0), d_numNodes(0) {}
+	frozen_trie( const trie_type& t ) : d_node(0), d_key(0), d_numNodes(0) { freeze(t); }
+
+	frozen_trie( const frozen_trie& o ) : 
+		d_nodeVec(o.d_nodeVec), d_keyVec(o.d_keyVec),
+		d_node(o.d_node), d_key(o.d_key), d_numNodes(o.d_numNodes),
+		d_mmap(o.d_mmap)
+	{ if( !d_nodeVec.empty() ) pointAtVectors(); }
+
+	frozen_trie& operator=( const frozen_trie& o ) 
+	{
+		if( this != &o ) {
+			d_nodeVec = o.d_nodeVec;
+			d_keyVec = o.d_keyVec;
+			d_node = o.d_node;
+			d_key = o.d_key;
+			d_numNodes = o.d_numNodes;
+			d_mmap = o.d_mmap;
+			if( !d_nodeVec.empty() ) pointAtVectors();
+		}
+		return *this;
+	}
+
+	/// rebuilds this from t. t can be destroyed afterwards
+	/// T is trie_type or anything with the same node interface (char_trie, arena_trie)
+	template <typename T>
+	void freeze( const T& t )
+	{
+		typedef typename T::VecMap::data_type::type node_type;
+		clear();
+		std::vector< const node_type* > q;
+		q.push_back( &t );
+		d_nodeVec.push_back( node(t.data()) );
+		d_keyVec.push_back( K() );
+
+		for( size_t i = 0; i< q.size(); ++i ) {
+			const node_type* n = q[i];
+			d_nodeVec[i].d_firstChild = d_nodeVec.size();
+			d_nodeVec[i].d_numChildren = n->getNumChildren();
+			for( typename node_type::VecMap::const_iterator c = n->childBegin(); c!= n->childEnd(); ++c ) {
+				const node_type& child = c->second.get();
+				q.push_back( &child );
+				d_keyVec.push_back( c->first );
+				d_nodeVec.push_back( node(child.data()) );
+			}
+		}
+		std::vector< node >(d_nodeVec).swap(d_nodeVec);
+		std::vector< K >(d_keyVec).swap(d_keyVec);
+		pointAtVectors();
+	}
+	void clear()
+	{
+		d_nodeVec.clear();
+		d_keyVec.clear();
+		d_mmap.reset();
+		pointAtVectors();
+	}
+
+	/// binary image - header, node array, key array. 
+	/// the image has no pointers in it so it can be mapped at any address. 
+	/// D and K must be plain data (no pointers, no heap memory) 
+	/// returns 0 on success
+	int serialize( std::ostream& fp ) const
+	{
+		binary_image_header hdr( imageMagic(), IMAGE_VERSION, sizeof(node), sizeof(K), d_numNodes );
+		binary_image_write( fp, &hdr, sizeof(hdr) );
+		// nodes are rebuilt in zeroed memory so that padding bytes dont leak into the image
+		enum : size_t { NODES_PER_WRITE = 4096 };
+		std::vector< char > buf;
+		for( size_t i = 0; i< d_numNodes; ) {
+			size_t n = std::min( (size_t)NODES_PER_WRITE, d_numNodes-i );
+			buf.assign( n*sizeof(node), 0 );
+			for( size_t j = 0; j< n; ++j, ++i ) {
+				node* x = new (&(buf[j*sizeof(node)])) node( d_node[i].d_data );
+				x->d_firstChild = d_node[i].d_firstChild;
+				x->d_numChildren = d_node[i].d_numChildren;
+			}
+			binary_image_write( fp, buf.data(), buf.size() ); // only the last chunk gets padded
+		}
+		binary_image_write( fp, d_key, d_numNodes*sizeof(K) );
+		return ( fp.good() ? 0 : -1 );
+	}
+	/// queries will run directly against buf (nothing is copied)
+	/// buf must outlive this object and be aligned at BINARY_IMAGE_ALIGN
+	/// returns 0 on success, -1 if buf isnt a valid image
+	/// only the header and the section bounds are checked - attaching doesnt touch the nodes. 
+	/// images from untrusted sources should be checked with verify()
+	int attach( const char* buf, size_t buf_sz )
+	{
+		clear();
+		if( buf_sz < sizeof(binary_image_header) ) 
+			return -1;
+		const binary_image_header* hdr = (const binary_image_header*)buf;
+		if( !hdr->matches( imageMagic(), IMAGE_VERSION, sizeof(node), sizeof(K) ) ) 
+			return -1;
+
+		// sizes are checked before they are multiplied so that a corrupt header cant wrap them
+		if( hdr->numElem > buf_sz/sizeof(node) || hdr->numElem > buf_sz/sizeof(K) ) 
+			return -1;
+		size_t nodeOffset = binary_image_align( sizeof(binary_image_header) );
+		size_t keyOffset = nodeOffset + binary_image_align( hdr->numElem*sizeof(node) );
+		if( keyOffset > buf_sz || hdr->numElem*sizeof(K) > buf_sz - keyOffset ) 
+			return -1;
+		d_numNodes = hdr->numElem;
+		d_node = ( d_numNodes ? (const node*)(buf+nodeOffset) : 0 );
+		d_key = ( d_numNodes ? (const K*)(buf+keyOffset) : 0 );
+		return 0;
+	}
+	/// maps file written by serialize read only and attaches to it
+	int load( const char* path )
+	{
+		std::shared_ptr<mmap_file> m( new mmap_file );
+		if( m->open(path) || attach( m->data(), m->size() ) ) 
+			return -1;
+		d_mmap = m;
+		return 0;
+	}
+	/// full check of the nodes (reads all of them) - every child range must be within the node array. 
+	/// returns 0 if lookups are safe, -1 otherwise
+	int verify() const
+	{
+		for( size_t i = 0; i< d_numNodes; ++i ) {
+			if( (uint64_t)d_node[i].d_firstChild + d_node[i].d_numChildren > d_numNodes ) 
+				return -1;
+		}
+		return 0;
+	}
+
+	bool empty() const { return !d_numNodes; }
+	size_t getNumNodes() const { return d_numNodes; }
+	/// approximate number of heap bytes used by the structure (mapped images arent counted)
+	size_t getMemoryUsage() const { return ( d_nodeVec.capacity()*sizeof(node) + d_keyVec.capacity()*sizeof(K) ); }
+
+	const node* root() const { return d_node; }
+
+	/// offset of the node in breadth first order (root is 0)
+	size_t getNodeIdx( const node* n ) const { return ( n - d_node ); }
+	const node& getNode( size_t idx ) const { return d_node[idx]; }
+	const K& getKey( const node* n ) const { return d_key[ getNodeIdx(n) ]; }
+
+	const K* childKeyBegin( const node* n ) const { return d_key + n->d_firstChild; }
+	const K* childKeyEnd( const node* n ) const { return d_key + n->d_firstChild + n->d_numChildren; }
+	const node* childBegin( const node* n ) const { return d_node + n->d_firstChild; }
+	const node* childEnd( const node* n ) const { return d_node + n->d_firstChild + n->d_numChildren; }
+
+	/// returns child of n reachable by key or 0
+	const node* find( const node* n, const key_type& key ) const
+	{
+		if( !n->d_numChildren )
+			return 0;
+		const K* kb = childKeyBegin(n);
+		const K* k = frozen_trie_key_search<K,Comp>::find( kb, kb + n->d_numChildren, key );
+		return ( k ? d_node + (k-d_key) : 0 );
+	}
+
+	/// same semantics as trie::getLongestPath - returns the deepest node matched (or 0)
+	/// and the iterator past the last matched key
+	template <class FI>
+	std::pair< const node*, FI> getLongestPath( FI start, FI end ) const
+	{
+		const node* found = 0;
+		for( const node* n = root(); n && start != end; ++start ) {
+			if( !(n= find(n,*start)) )
+				break;
+			found = n;
+		}
+		return std::pair< const node*, FI>( found, start );
+	}
+
+	/// same semantics as trie::getTerminatedLongestPath
+	template <class FI>
+	std::pair< const node*, FI> getTerminatedLongestPath( FI start, typename std::iterator_traits<FI>::value_type end ) const
+	{
+		const node* found = 0;
+		for( const node* n = root(); n && !(*start == end); ++start ) {
+			if( !(n= find(n,*start)) )
+				break;
+			found = n;
+		}
+		return std::pair< const node*, FI>( found, start );
+	}
+};
+
+template<typename D>
+class frozen_char_trie : public frozen_trie<char, D> {
+public:
+	typedef frozen_trie<char,D> Frozen;
+
+	frozen_char_trie() {}
+	frozen_char_trie( const trie<char,D>& t ) : Frozen(t) {}
+
+	std::pair<const typename Frozen::node*, const char*> matchString(const char *s) const
+		{ return this->getTerminatedLongestPath( s, (char)(0) ); }
+};
+
+} // namespace yay
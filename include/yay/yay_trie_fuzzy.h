@@ -0,0 +1,150 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_trie.h"
+#include <vector>
+#include <cstring>
+
+namespace yay {
+
+/// bounded levenshtein search over a trie
+/// instead of computing edit distance against every dictionary word the trie is walked
+/// depth first and one row of the levenshtein matrix is computed per node. the row
+/// for a node is shared by all keys under it, so whenever the row minimum exceeds
+/// maxDist the whole subtree is skipped
+///
+/// same as LevenshteinEditDistance this is a reusable object - it keeps its buffers
+/// between calls
+///     yay::trie_fuzzy_matcher< yay::char_trie<uint32_t> > fuzzy;
+///     std::vector< ... ::match > res;
+///     fuzzy.search( t, "helo", 1, res, 0xffffffff );
+///
+/// T must be an yay::trie<> (or char_trie). nodes whose data equals noValue
+/// (the default passed to add for intermediate nodes) are never reported
+template <typename T>
+class trie_fuzzy_matcher {
+public:
+	typedef T trie_type;
+	typedef typename T::VecMap::data_type::type node_type; // char_trie children are plain trie<char,D>
+	typedef typename T::key_type key_type;
+	typedef typename T::data_type data_type;
+	typedef std::vector< key_type > Key;
+
+	struct match {
+		Key       key;
+		data_type data;
+		int       distance;
+
+		match( const Key& k, const data_type& d, int dist ) : key(k), data(d), distance(dist) {}
+	};
+	typedef std::vector< match > MatchVec;
+private:
+	std::vector< int > d_rows; // d_rows[ depth*(d_qSz+1) + j ]
+	Key d_path;
+
+	const key_type* d_q;
+	size_t          d_qSz;
+	int             d_maxDist;
+	data_type       d_noValue;
+
+	int* row( size_t depth ) { return &(d_rows[ depth*(d_qSz+1) ]); }
+
+	/// returns false if the callback aborted the search
+	template <typename CB>
+	bool visit( const node_type& n, size_t depth, CB& cb, size_t& numFound )
+	{
+		for( typename node_type::VecMap::const_iterator i = n.childBegin(); i!= n.childEnd(); ++i ) {
+			if( d_rows.size() < (depth+2)*(d_qSz+1) )
+				d_rows.resize( (depth+2)*(d_qSz+1) );
+			const int* prev = row(depth);
+			int* cur = row(depth+1);
+
+			const key_type& c = i->first;
+			cur[0] = prev[0]+1;
+			int rowMin = cur[0];
+			for( size_t j = 1; j<= d_qSz; ++j ) {
+				int x = prev[j-1] + ( d_q[j-1] == c ? 0 : 1 );
+				if( prev[j]+1 < x ) x = prev[j]+1;
+				if( cur[j-1]+1 < x ) x = cur[j-1]+1;
+				cur[j] = x;
+				if( x < rowMin ) rowMin = x;
+			}
+			if( rowMin > d_maxDist )
+				continue;
+
+			const node_type& child = i->second.get();
+			d_path.push_back( c );
+			if( cur[d_qSz] <= d_maxDist && !(child.data() == d_noValue) ) {
+				++numFound;
+				if( !cb( d_path, child.data(), cur[d_qSz] ) )
+					return false;
+			}
+			if( !child.isLeaf() && !visit( child, depth+1, cb, numFound ) )
+				return false;
+			d_path.pop_back();
+		}
+		return true;
+	}
+	struct collect_cb {
+		MatchVec& vec;
+		collect_cb( MatchVec& v ) : vec(v) {}
+		bool operator()( const Key& k, const data_type& d, int dist )
+			{ return ( vec.push_back( match(k,d,dist) ), true ); }
+	};
+public:
+	trie_fuzzy_matcher() : d_q(0), d_qSz(0), d_maxDist(0), d_noValue() {}
+
+	/// CB must have bool operator()( const std::vector<key_type>& key, const data_type& data, int distance )
+	/// it's invoked for every key within maxDist of q. returning false stops the search
+	/// returns the number of keys reported
+	template <typename CB>
+	size_t search( const trie_type& t, const key_type* q, size_t q_sz, int maxDist, CB& cb, const data_type& noValue = data_type() )
+	{
+		d_q = q;
+		d_qSz = q_sz;
+		d_maxDist = maxDist;
+		d_noValue = noValue;
+		d_path.clear();
+		if( d_rows.size() < q_sz+1 )
+			d_rows.resize( q_sz+1 );
+		for( size_t j = 0; j<= q_sz; ++j )
+			d_rows[j] = j;
+
+		size_t numFound = 0;
+		visit( t, 0, cb, numFound );
+		return numFound;
+	}
+	/// appends all keys within maxDist of q to result
+	size_t search( const trie_type& t, const key_type* q, size_t q_sz, int maxDist, MatchVec& result, const data_type& noValue = data_type() )
+	{
+		collect_cb cb(result);
+		return search( t, q, q_sz, maxDist, cb, noValue );
+	}
+	/// null terminated query (for char_trie)
+	size_t search( const trie_type& t, const char* q, int maxDist, MatchVec& result, const data_type& noValue = data_type() )
+		{ return search( t, q, strlen(q), maxDist, result, noValue ); }
+};
+
+} // namespace yay
@@ -0,0 +1,113 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_trie.h"
+#include <boost/thread.hpp>
+#include <vector>
+#include <iterator>
+#include <exception>
+
+namespace yay {
+
+/// builds a trie on several threads
+/// the input range is split into numThreads contiguous shards, every shard is loaded into its own 
+/// trie in parallel and then the shard tries are merged pairwise (also in parallel) with trie::merge
+///
+/// RI - random access iterator over the input
+/// Adder must have void operator()( T& t, const std::iterator_traits<RI>::value_type& v ) - adds one element
+/// Updater must have T::data_type operator()( const data_type& mine, const data_type& theirs ) - same as in
+/// trie::merge. theirs always comes from the later part of the input so an updater returning theirs
+/// (whenever it's not the default value) gives the same trie as adding everything sequentially
+///
+///     std::vector< std::pair<std::string,uint32_t> > words; ...
+///     yay::char_trie<uint32_t> t;
+///     yay::trie_parallel_build( t, words.begin(), words.end(),
+///         []( yay::char_trie<uint32_t>& t, const std::pair<std::string,uint32_t>& w ) { t.add( w.first.c_str(), w.second, 0xffffffff ); },
+///         []( uint32_t mine, uint32_t theirs ) { return ( theirs == 0xffffffff ? mine : theirs ); } );
+/// 
+/// whatever is already in t is kept (merged with the rest same way)
+/// every thread works with its own copy of add and upd. an exception thrown on a worker 
+/// thread is rethrown here once all threads have finished (the first one if there are several)
+template <typename T, typename RI, typename Adder, typename Updater>
+void trie_parallel_build( T& t, RI begin, RI end, Adder add, Updater upd, size_t numThreads = 0 )
+{
+	if( !numThreads ) 
+		numThreads = boost::thread::hardware_concurrency();
+	size_t sz = std::distance( begin, end );
+	if( numThreads > sz/1024 ) // not worth a thread
+		numThreads = sz/1024;
+	if( numThreads < 2 ) {
+		for( RI i = begin; i!= end; ++i ) 
+			add( t, *i );
+		return;
+	}
+
+	std::vector< T > shard( numThreads );
+	std::vector< std::exception_ptr > err( numThreads ); // err[s] - thrown by the thread working on shard[s]
+	auto rethrow = [&err]() {
+		for( size_t s = 0; s< err.size(); ++s ) {
+			if( err[s] ) 
+				std::rethrow_exception( err[s] );
+		}
+	};
+	{ // loading
+		boost::thread_group threads;
+		for( size_t s = 0; s< numThreads; ++s ) {
+			RI b = begin + sz*s/numThreads, e = begin + sz*(s+1)/numThreads;
+			T* st = &(shard[s]);
+			std::exception_ptr* ep = &(err[s]);
+			threads.create_thread( [st,b,e,ep,add]() mutable {
+				try {
+					for( RI i = b; i!= e; ++i ) 
+						add( *st, *i );
+				} catch( ... ) {
+					*ep = std::current_exception();
+				}
+			} );
+		}
+		threads.join_all();
+		rethrow();
+	}
+	// merging pairs of neighbours - shard[s] absorbs shard[s+step]
+	for( size_t step = 1; step < numThreads; step *= 2 ) {
+		boost::thread_group threads;
+		for( size_t s = 0; s+step < numThreads; s += 2*step ) {
+			T* mine = &(shard[s]), *theirs = &(shard[s+step]);
+			std::exception_ptr* ep = &(err[s]);
+			threads.create_thread( [mine,theirs,ep,upd]() mutable { 
+				try {
+					mine->merge( *theirs, upd ); 
+				} catch( ... ) {
+					*ep = std::current_exception();
+				}
+			} );
+		}
+		threads.join_all();
+		rethrow();
+	}
+	t.merge( shard[0], upd );
+}
+
+} // namespace yay
@@ -0,0 +1,206 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_trie_frozen.h"
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>
+
+namespace yay {
+
+/// autocomplete over a char trie
+/// every node caches the best score found anywhere in its subtree, so topK walks the subtree 
+/// under the prefix best first and stops after k completions - the work depends on k and the 
+/// depth of the results, not on the size of the subtree. children are linked in descending 
+/// subtree score order and a child is only put on the frontier once its better sibling has 
+/// been taken off it, so wide nodes dont flood the frontier
+///
+/// built once from a char_trie (or arena/char trie with the same interface):
+///     yay::topk_trie<uint32_t,uint32_t> ac( 0xffffffff );
+///     ac.build( t, [&]( uint32_t id ) { return popularity[id]; } );
+///     std::vector< yay::topk_trie<uint32_t,uint32_t>::result > res;
+///     ac.topK( "hel", 10, res );
+/// nodes whose data equals noValue are not completions
+template <typename D, typename S=double>
+class topk_trie {
+public:
+	typedef frozen_char_trie<D> Frozen;
+	typedef typename Frozen::node node;
+	typedef S score_type;
+
+	struct result {
+		std::string key;
+		D           data;
+		S           score;
+
+		result( const std::string& k, const D& d, S s ) : key(k), data(d), score(s) {}
+	};
+	typedef std::vector< result > ResultVec;
+private:
+	Frozen                  d_trie;
+	std::vector< S >        d_maxScore; // best score in the subtree of the node (lowest() if none)
+	std::vector< S >        d_score;    // score of the node itself
+	std::vector< uint32_t > d_parent;
+	std::vector< uint32_t > d_bestChild;   // child with the best subtree score (0 - none)
+	std::vector< uint32_t > d_nextSibling; // next child of the parent in subtree score order (0 - none)
+	D                       d_noValue;
+
+	struct heap_entry {
+		S        score;
+		uint32_t nodeIdx;
+		bool     isCompletion; // false - subtree still has to be expanded
+
+		heap_entry( S s, uint32_t n, bool c ) : score(s), nodeIdx(n), isCompletion(c) {}
+		bool operator<( const heap_entry& o ) const 
+			{ return ( score < o.score || (!(o.score < score) && !isCompletion && o.isCompletion) ); }
+	};
+	static S noScore() { return std::numeric_limits<S>::lowest(); }
+
+	bool isCompletion( uint32_t n ) const { return !(d_trie.getNode(n).data() == d_noValue); }
+
+	std::string& getKey( std::string& k, uint32_t n ) const
+	{
+		k.clear();
+		for( ; n; n = d_parent[n] ) 
+			k.push_back( d_trie.getKey( &(d_trie.getNode(n)) ) );
+		std::reverse( k.begin(), k.end() );
+		return k;
+	}
+public:
+	topk_trie( const D& noValue = D() ) : d_noValue(noValue) {}
+
+	/// SF is S operator()( const D& ) - score of a completion
+	template <typename T, typename SF>
+	void build( const T& t, SF scoreOf )
+	{
+		d_trie.freeze(t);
+		size_t numNodes = d_trie.getNumNodes();
+		d_score.assign( numNodes, noScore() );
+		d_maxScore.assign( numNodes, noScore() );
+		d_parent.assign( numNodes, 0 );
+
+		for( size_t i = 0; i< numNodes; ++i ) {
+			const node* n = &(d_trie.getNode(i));
+			for( const node* c = d_trie.childBegin(n); c!= d_trie.childEnd(n); ++c ) 
+				d_parent[ d_trie.getNodeIdx(c) ] = i;
+			if( i && isCompletion(i) ) 
+				d_maxScore[i] = d_score[i] = scoreOf( n->data() );
+		}
+		// nodes are in breadth first order - children always come after the parent
+		for( size_t i = numNodes; i-- > 1; ) {
+			S& p = d_maxScore[ d_parent[i] ];
+			if( p < d_maxScore[i] ) 
+				p = d_maxScore[i];
+		}
+		// children without completions are left out of the links
+		d_bestChild.assign( numNodes, 0 );
+		d_nextSibling.assign( numNodes, 0 );
+		std::vector< uint32_t > ord;
+		const std::vector< S >& maxScore = d_maxScore;
+		for( size_t i = 0; i< numNodes; ++i ) {
+			const node* n = &(d_trie.getNode(i));
+			ord.clear();
+			for( const node* c = d_trie.childBegin(n); c!= d_trie.childEnd(n); ++c ) {
+				uint32_t ci = d_trie.getNodeIdx(c);
+				if( !(d_maxScore[ci] == noScore()) ) 
+					ord.push_back( ci );
+			}
+			if( ord.empty() ) 
+				continue;
+			std::sort( ord.begin(), ord.end(), [&maxScore]( uint32_t a, uint32_t b ) { 
+				return ( maxScore[b] < maxScore[a] || ( !(maxScore[a] < maxScore[b]) && a < b ) ); 
+			} );
+			d_bestChild[i] = ord[0];
+			for( size_t j = 1; j< ord.size(); ++j ) 
+				d_nextSibling[ ord[j-1] ] = ord[j];
+		}
+	}
+	void clear()
+	{
+		d_trie.clear();
+		d_maxScore.clear();
+		d_score.clear();
+		d_parent.clear();
+		d_bestChild.clear();
+		d_nextSibling.clear();
+	}
+	size_t getNumNodes() const { return d_trie.getNumNodes(); }
+
+	/// appends up to k best completions of prefix to res in descending score order
+	/// returns number of completions appended
+	size_t topK( const char* prefix, size_t k, ResultVec& res ) const
+	{
+		if( d_trie.empty() || !k ) 
+			return 0;
+		uint32_t start = 0;
+		if( *prefix ) {
+			std::pair< const node*, const char* > m = d_trie.matchString( prefix );
+			if( *(m.second) || !m.first ) // prefix isnt in the trie
+				return 0;
+			start = d_trie.getNodeIdx( m.first );
+		}
+		if( d_maxScore[start] == noScore() ) 
+			return 0;
+
+		// frontier - every subtree entry taken off it puts back at most its own completion, its 
+		// best child and its next sibling, so it stays O(k * depth) whatever the fan out
+		std::vector< heap_entry > heap;
+		if( start && isCompletion(start) ) 
+			heap.push_back( heap_entry(d_score[start], start, true) );
+		if( d_bestChild[start] ) 
+			heap.push_back( heap_entry(d_maxScore[ d_bestChild[start] ], d_bestChild[start], false) );
+		std::make_heap( heap.begin(), heap.end() );
+		size_t numFound = 0;
+		std::string key;
+		while( !heap.empty() && numFound < k ) {
+			std::pop_heap( heap.begin(), heap.end() );
+			heap_entry e = heap.back();
+			heap.pop_back();
+			if( e.isCompletion ) {
+				const node& n = d_trie.getNode(e.nodeIdx);
+				res.push_back( result( getKey(key,e.nodeIdx), n.data(), e.score ) );
+				++numFound;
+				continue;
+			}
+			if( uint32_t sib = d_nextSibling[e.nodeIdx] ) {
+				heap.push_back( heap_entry(d_maxScore[sib], sib, false) );
+				std::push_heap( heap.begin(), heap.end() );
+			}
+			if( isCompletion(e.nodeIdx) ) {
+				heap.push_back( heap_entry(d_score[e.nodeIdx], e.nodeIdx, true) );
+				std::push_heap( heap.begin(), heap.end() );
+			}
+			if( uint32_t c = d_bestChild[e.nodeIdx] ) {
+				heap.push_back( heap_entry(d_maxScore[c], c, false) );
+				std::push_heap( heap.begin(), heap.end() );
+			}
+		}
+		return numFound;
+	}
+};
+
+} // namespace yay
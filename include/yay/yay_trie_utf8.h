@@ -0,0 +1,72 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include "yay/yay_utf8.h"
+#include "yay/yay_trie_arena.h"
+#include "yay/yay_trie_frozen.h"
+
+namespace yay {
+
+/// tries keyed by unicode code point instead of bytes - a cyrillic word takes 
+/// one node per glyph rather than two
+/// strings are added and matched straight from utf8 bytes via utf8_codepoint_iter 
+///
+/// utf8_trie is the mutable one (nodes on arena). for lookup heavy use freeze it 
+/// into frozen_utf8_trie - its child keys are packed and searched with SSE2
+template <typename D>
+class utf8_trie : public arena_trie<uint32_t, D> {
+public:
+	typedef arena_trie<uint32_t, D> Trie;
+
+	utf8_trie( size_t arenaChunkSz = bump_arena::DEFAULT_CHUNK_SIZE ) : Trie(arenaChunkSz) {}
+
+	void add( const char* s, const D& d, const D& defValue = D() )
+		{ this->addTerminatedKeyPath( utf8_codepoint_iter(s), 0, defValue ).data() = d; }
+
+	/// second is the pointer past the last matched byte
+	std::pair<const Trie*, const char*> matchString( const char* s ) const
+	{
+		std::pair<const Trie*, utf8_codepoint_iter> r = this->getTerminatedLongestPath( utf8_codepoint_iter(s), 0 );
+		return std::pair<const Trie*, const char*>( r.first, r.second.ptr() );
+	}
+};
+
+template <typename D>
+class frozen_utf8_trie : public frozen_trie<uint32_t, D> {
+public:
+	typedef frozen_trie<uint32_t, D> Frozen;
+	typedef typename Frozen::node node;
+
+	frozen_utf8_trie() {}
+	frozen_utf8_trie( const utf8_trie<D>& t ) { this->freeze(t); }
+
+	std::pair<const node*, const char*> matchString( const char* s ) const
+	{
+		std::pair<const node*, utf8_codepoint_iter> r = this->getTerminatedLongestPath( utf8_codepoint_iter(s), 0 );
+		return std::pair<const node*, const char*>( r.first, r.second.ptr() );
+	}
+};
+
+} // namespace yay
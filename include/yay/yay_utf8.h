@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include <cstddef>
 #include <string>
 #include <stdint.h>
+#include <cstring>
 #include "yay/yay_headers.h"
 
 namespace yay
@@ -573,6 +574,173 @@ namespace yay
         const_iterator end() const { return const_iterator(*this,size()); }
 	};
 
+	/// walks raw utf8 bytes and yields unicode code points (no StrUTF8/CharUTF8 is built)
+	/// malformed sequences are returned one byte at a time 
+	class utf8_codepoint_iter
+	{
+		const char* d_s;
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef uint32_t                  value_type;
+		typedef ptrdiff_t                 difference_type;
+		typedef const uint32_t*           pointer;
+		typedef uint32_t                  reference;
+
+		/// decodes code point at s, sz is set to the number of bytes it takes
+		static inline uint32_t decode( const char* ss, size_t& sz )
+		{
+			const uint8_t* s = (const uint8_t*)ss;
+			if( s[0] < 0x80 ) 
+				return ( sz=1, s[0] );
+			else if( (s[0]>>5) == 0x6 && (s[1]&0xC0) == 0x80 ) 
+				return ( sz=2, ((s[0]&0x1F)<<6) | (s[1]&0x3F) );
+			else if( (s[0]>>4) == 0xE && (s[1]&0xC0) == 0x80 && (s[2]&0xC0) == 0x80 ) 
+				return ( sz=3, ((s[0]&0xF)<<12) | ((s[1]&0x3F)<<6) | (s[2]&0x3F) );
+			else if( (s[0]>>3) == 0x1E && (s[1]&0xC0) == 0x80 && (s[2]&0xC0) == 0x80 && (s[3]&0xC0) == 0x80 ) 
+				return ( sz=4, ((s[0]&0x7)<<18) | ((s[1]&0x3F)<<12) | ((s[2]&0x3F)<<6) | (s[3]&0x3F) );
+			else 
+				return ( sz=1, s[0] );
+		}
+
+		explicit utf8_codepoint_iter( const char* s ) : d_s(s) {}
+
+		const char* ptr() const { return d_s; }
+
+		uint32_t operator*() const { size_t sz; return decode(d_s,sz); }
+		utf8_codepoint_iter& operator++() { size_t sz; decode(d_s,sz); d_s+=sz; return *this; }
+		utf8_codepoint_iter operator++(int) { utf8_codepoint_iter i(*this); ++(*this); return i; }
+
+		bool operator==( const utf8_codepoint_iter& o ) const { return d_s == o.d_s; }
+		bool operator!=( const utf8_codepoint_iter& o ) const { return d_s != o.d_s; }
+	};
+
+	/// simple case folding of a code point (the lowercase mapping from tableU2L). 
+	/// code points without a mapping are returned as is
+	uint32_t utf32_fold( uint32_t cp );
+
+	/// case insensitive hashing and comparison of raw utf8 (pointer + length, no terminal 0 needed)
+	/// nothing folded is ever materialized. ascii is folded 8 bytes at a time in a 64 bit word, 
+	/// 2 byte cyrillic arithmetically and the rest through utf32_fold
+	/// hash is a function of the folded utf8 byte stream, so strings whose case variants encode to 
+	/// different lengths still hash the same
+	struct utf8_casefold {
+		/// lowercases the 8 ascii bytes of w (w must not have bytes >= 0x80)
+		static inline uint64_t foldAsciiWord( uint64_t w )
+		{
+			const uint64_t ones = 0x0101010101010101ULL;
+			uint64_t geA = w + ones*(0x80-'A');
+			uint64_t gtZ = w + ones*(0x80-'Z'-1);
+			return ( w | ( ( (geA & ~gtZ) & (ones*0x80) ) >> 2 ) );
+		}
+		static inline bool isAsciiWord( uint64_t w ) { return !( w & 0x8080808080808080ULL ); }
+
+		/// folded code point at s, sz is set to the number of bytes it takes in s
+		static inline uint32_t foldAt( const char* s, size_t s_sz, size_t& sz )
+		{
+			uint8_t c = (uint8_t)s[0];
+			if( c < 0x80 ) 
+				return ( sz=1, ( c >= 'A' && c <= 'Z' ? c+0x20 : c ) );
+			if( s_sz >= 2 && (c == 0xD0 || c == 0xD1) && ((uint8_t)s[1] & 0xC0) == 0x80 ) { // cyrillic
+				uint32_t cp = ( (c&0x1F)<<6 ) | ( (uint8_t)s[1] & 0x3F );
+				sz = 2;
+				if( cp < 0x410 ) 
+					return cp + 0x50;
+				else if( cp < 0x430 ) 
+					return cp + 0x20;
+				else if( cp < 0x460 ) 
+					return cp;
+				return utf32_fold( cp ); // historic letters, case pairs are next to each other
+			}
+			uint32_t cp;
+			if( s_sz >= 4 ) 
+				cp = utf8_codepoint_iter::decode( s, sz );
+			else {
+				char tmp[4] = {0};
+				memcpy( tmp, s, s_sz );
+				cp = utf8_codepoint_iter::decode( tmp, sz );
+			}
+			return utf32_fold( cp );
+		}
+
+		static inline size_t encode( uint32_t cp, uint8_t* out )
+		{
+			if( cp < 0x80 ) 
+				return ( out[0] = cp, 1 );
+			else if( cp < 0x800 ) 
+				return ( out[0] = 0xC0|(cp>>6), out[1] = 0x80|(cp&0x3F), 2 );
+			else if( cp < 0x10000 ) 
+				return ( out[0] = 0xE0|(cp>>12), out[1] = 0x80|((cp>>6)&0x3F), out[2] = 0x80|(cp&0x3F), 3 );
+			else 
+				return ( out[0] = 0xF0|(cp>>18), out[1] = 0x80|((cp>>12)&0x3F), out[2] = 0x80|((cp>>6)&0x3F), out[3] = 0x80|(cp&0x3F), 4 );
+		}
+
+		static uint64_t hash( const char* s, size_t s_sz )
+		{
+			const uint64_t M = 0x9E3779B97F4A7C15ULL;
+			uint64_t h = 0, w = 0;
+			size_t wSz = 0, totalSz = 0; // bytes in w, folded bytes hashed
+			const char* s_end = s+s_sz;
+			while( s < s_end ) {
+				if( !wSz && s_end-s >= 8 ) {
+					uint64_t x;
+					memcpy( &x, s, 8 );
+					if( isAsciiWord(x) ) {
+						h = ( h ^ foldAsciiWord(x) ) * M;
+						h ^= ( h >> 29 );
+						s += 8;
+						totalSz += 8;
+						continue;
+					}
+				}
+				size_t sz;
+				uint8_t buf[4];
+				size_t buf_sz = encode( foldAt( s, s_end-s, sz ), buf );
+				s += sz;
+				totalSz += buf_sz;
+				for( size_t i = 0; i< buf_sz; ++i ) {
+					w |= (uint64_t)buf[i] << (8*wSz);
+					if( ++wSz == 8 ) {
+						h = ( h ^ w ) * M;
+						h ^= ( h >> 29 );
+						w = 0;
+						wSz = 0;
+					}
+				}
+			}
+			if( wSz ) 
+				h = ( h ^ w ) * M;
+			h ^= totalSz * M;
+			h ^= ( h >> 32 );
+			h *= 0xD6E8FEB86659FD93ULL;
+			return ( h ^ (h >> 32) );
+		}
+
+		static bool equal( const char* l, size_t l_sz, const char* r, size_t r_sz )
+		{
+			const char* l_end = l+l_sz, *r_end = r+r_sz;
+			while( l < l_end && r < r_end ) {
+				if( l_end-l >= 8 && r_end-r >= 8 ) {
+					uint64_t lw, rw;
+					memcpy( &lw, l, 8 );
+					memcpy( &rw, r, 8 );
+					if( isAsciiWord(lw|rw) ) {
+						if( foldAsciiWord(lw) != foldAsciiWord(rw) ) 
+							return false;
+						l += 8;
+						r += 8;
+						continue;
+					}
+				}
+				size_t lsz, rsz;
+				if( foldAt( l, l_end-l, lsz ) != foldAt( r, r_end-r, rsz ) ) 
+					return false;
+				l += lsz;
+				r += rsz;
+			}
+			return ( l == l_end && r == r_end );
+		}
+	};
+
 int unicode_normalize_punctuation( std::string& outStr, const char* srcStr, size_t srcStr_sz ) ;
 int unicode_normalize_punctuation( std::string& qstr ) ;
 } // yay namespace
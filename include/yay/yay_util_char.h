@@ -27,6 +27,8 @@ THE SOFTWARE.
 #include <vector>
 #include <map>
 #include <set>
+#include <string>
+#include <stdint.h>
 #include <ctype.h>
 #include <yay/yay_ru_chars.h>
 
@@ -186,6 +188,55 @@ struct char_cp_hash {
         return h; // or, h % ARRAY_SIZE;
     }
 };
+/// pointer + length. the string doesnt have to be 0 terminated
+class char_span {
+	const char* d_s;
+	size_t      d_sz;
+public:
+	char_span() : d_s(""), d_sz(0) {}
+	char_span( const char* s ) : d_s(s), d_sz(strlen(s)) {}
+	char_span( const char* s, size_t sz ) : d_s(s), d_sz(sz) {}
+	char_span( const std::string& s ) : d_s(s.data()), d_sz(s.length()) {}
+
+	const char* data() const { return d_s; }
+	size_t size() const { return d_sz; }
+	bool empty() const { return !d_sz; }
+
+	const char* begin() const { return d_s; }
+	const char* end() const { return d_s+d_sz; }
+
+	bool operator==( const char_span& o ) const 
+		{ return ( d_sz == o.d_sz && !memcmp(d_s,o.d_s,d_sz) ); }
+};
+
+/// hashes 8 bytes at a time (the tail is read as one zero padded word)
+/// much faster than char_cp_hash on anything longer than a few characters. not stable across 
+/// endianness - dont persist it
+struct char_span_hash {
+	inline uint64_t operator()( const char* s, size_t sz ) const
+	{
+		const uint64_t M = 0x9E3779B97F4A7C15ULL;
+		uint64_t h = sz * M;
+		for( ; sz >= 8; s += 8, sz -= 8 ) {
+			uint64_t w;
+			memcpy( &w, s, 8 );
+			h = ( h ^ w ) * M;
+			h ^= ( h >> 29 );
+		}
+		if( sz ) {
+			uint64_t w = 0;
+			memcpy( &w, s, sz );
+			h = ( h ^ w ) * M;
+		}
+		h ^= ( h >> 32 );
+		h *= 0xD6E8FEB86659FD93ULL;
+		return ( h ^ (h >> 32) );
+	}
+	inline uint64_t operator()( const char_span& s ) const
+		{ return (*this)( s.data(), s.size() ); }
+	inline uint64_t operator()( const char* s ) const
+		{ return ( s ? (*this)( s, strlen(s) ) : 0 ); }
+};
 struct char_cp_hash_nocase {
     inline size_t operator()( const char* s ) const
     {
@@ -156,6 +156,10 @@ public:
 	iterator erase( iterator pos ) { return d_vec.erase(pos); }
 	iterator erase( iterator first, iterator last ) { return d_vec.erase(first,last); }
 
+	/// replaces the contents with v (old contents end up in v)
+	/// v must be sorted by key and keys must be unique
+	void swapVector( TheVec& v ) { d_vec.swap(v); }
+
 	size_t size() const { return d_vec.size(); }
 
 	/// i has to be a number, not K
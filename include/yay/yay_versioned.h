@@ -0,0 +1,185 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#pragma once
+#include <yay/yay_headers.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+namespace yay {
+
+/// versioned holds the current version of a read mostly object (typically a dictionary trie) 
+/// readers take snapshots without locking, writers build a new version and publish it
+/// old versions are destroyed once no reader can still be looking at them (epoch based reclamation)
+///
+///     yay::versioned< yay::char_trie<uint32_t> > dict( new yay::char_trie<uint32_t> );
+///     // any number of reader threads
+///     {
+///         auto snap = dict.read(); 
+///         snap->matchString( s ); 
+///     } // snapshot released
+///     // writer thread
+///     dict.publish( newTrie ); 
+///     // or copy the current version, modify it and publish
+///     dict.update( [&]( yay::char_trie<uint32_t>& t ) { t.add( "hello", 1 ); } );
+///
+/// a reader announces the global epoch in a slot and then loads the current pointer
+/// a retired version is tagged with the epoch following its replacement and is freed 
+/// when no slot holds an older epoch. readers never wait for writers. 
+/// MAX_READERS is the max number of snapshots alive at the same time - if all slots are taken
+/// read() spins until one is released
+template <typename T, size_t MAX_READERS=64>
+class versioned {
+	enum : size_t { CACHE_LINE = 64 };
+	struct slot {
+		std::atomic<uint64_t> epoch; // 0 - free, otherwise epoch the reader entered in
+		char pad[ CACHE_LINE-sizeof(std::atomic<uint64_t>) ];
+		slot() : epoch(0) {}
+	};
+	mutable slot d_slot[ MAX_READERS ];
+
+	std::atomic<T*>       d_cur;
+	std::atomic<uint64_t> d_epoch; // starts at 1
+
+	struct retired {
+		T*       obj;
+		uint64_t epoch; // obj can be freed when all readers are in this epoch or later
+	};
+	std::vector< retired > d_retired; // guarded by d_writerMtx
+	std::mutex             d_writerMtx;
+	std::mutex             d_updateMtx; // serializes update() so concurrent updates dont lose each other's changes
+
+	size_t acquireSlot() const
+	{
+		static thread_local size_t hint = 0;
+		uint64_t e = d_epoch.load();
+		for( size_t i = hint; ; i = (i+1)%MAX_READERS ) {
+			uint64_t expected = 0;
+			if( d_slot[i].epoch.compare_exchange_strong( expected, e ) ) 
+				return (hint = i);
+		}
+	}
+	/// must be called with d_writerMtx locked
+	size_t reclaimLocked()
+	{
+		uint64_t minEpoch = UINT64_MAX;
+		for( size_t i = 0; i< MAX_READERS; ++i ) {
+			uint64_t e = d_slot[i].epoch.load();
+			if( e && e < minEpoch ) 
+				minEpoch = e;
+		}
+		size_t j = 0;
+		for( size_t i = 0; i< d_retired.size(); ++i ) {
+			if( d_retired[i].epoch <= minEpoch ) 
+				delete d_retired[i].obj;
+			else 
+				d_retired[j++] = d_retired[i];
+		}
+		d_retired.resize(j);
+		return j;
+	}
+public:
+	/// RAII read handle. the version it points to stays alive as long as the snapshot does
+	class snapshot {
+		const versioned* d_v;
+		size_t           d_slot;
+		const T*         d_obj;
+
+		friend class versioned;
+		snapshot( const versioned* v, size_t s, const T* o ) : d_v(v), d_slot(s), d_obj(o) {}
+	public:
+		snapshot( const snapshot& ) = delete;
+		snapshot& operator=( const snapshot& ) = delete;
+		snapshot( snapshot&& o ) : d_v(o.d_v), d_slot(o.d_slot), d_obj(o.d_obj) { o.d_v = 0; }
+		~snapshot() { release(); }
+
+		void release() 
+		{
+			if( d_v ) {
+				d_v->d_slot[d_slot].epoch.store(0);
+				d_v = 0;
+				d_obj = 0;
+			}
+		}
+		const T* get() const { return d_obj; }
+		const T& operator*() const { return *d_obj; }
+		const T* operator->() const { return d_obj; }
+	};
+
+	versioned( const versioned& ) = delete;
+	versioned& operator=( const versioned& ) = delete;
+
+	/// takes ownership of t
+	versioned( T* t = 0 ) : d_cur(t), d_epoch(1) {}
+	~versioned()
+	{
+		delete d_cur.load();
+		for( auto& r : d_retired ) 
+			delete r.obj;
+	}
+
+	/// lock free - never blocks on writers
+	snapshot read() const
+	{
+		size_t s = acquireSlot();
+		return snapshot( this, s, d_cur.load() );
+	}
+
+	/// makes t the current version (takes ownership). the previous version is destroyed 
+	/// as soon as the last reader holding it is gone. returns number of versions 
+	/// still waiting for readers
+	size_t publish( T* t )
+	{
+		std::lock_guard<std::mutex> lock( d_writerMtx );
+		T* old = d_cur.exchange(t);
+		uint64_t e = d_epoch.fetch_add(1)+1;
+		if( old ) 
+			d_retired.push_back( retired({old,e}) );
+		return reclaimLocked();
+	}
+	/// copies the current version, applies f( T& ) to the copy and publishes it
+	template <typename F>
+	size_t update( F f )
+	{
+		std::lock_guard<std::mutex> updLock( d_updateMtx );
+		T* t = 0;
+		{
+			snapshot cur = read(); // keeps the version alive while it's being copied
+			t = ( cur.get() ? new T(*cur) : new T() );
+		}
+		f(*t);
+		return publish(t);
+	}
+	/// frees retired versions no reader can see any more. returns number still pending 
+	size_t reclaim()
+	{
+		std::lock_guard<std::mutex> lock( d_writerMtx );
+		return reclaimLocked();
+	}
+	uint64_t getVersion() const { return d_epoch.load(); }
+};
+
+} // namespace yay
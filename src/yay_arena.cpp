@@ -0,0 +1,78 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#include <yay/yay_arena.h>
+
+namespace yay {
+
+bump_arena::bump_arena( size_t cSz ) :
+	d_chunkCapacity(cSz),
+	d_chunkSz(0),
+	d_bytesUsed(0)
+{}
+
+bump_arena::~bump_arena()
+{
+	clear();
+}
+
+void bump_arena::clear()
+{
+	for( ChunkVec::iterator i = d_chunk.begin(); i!= d_chunk.end(); ++i ) 
+		free( *i );
+	d_chunk.clear();
+	d_chunkSz = 0;
+	d_bytesUsed = 0;
+}
+
+char* bump_arena::addNewChunk( size_t sz )
+{
+	d_chunk.push_back( (char*)malloc(sz) );
+	return d_chunk.back();
+}
+
+void* bump_arena::alloc( size_t sz, size_t align )
+{
+	if( sz + align > d_chunkCapacity ) { // oversized - gets its own chunk, current chunk stays current
+		char* buf = addNewChunk( sz + align );
+		if( d_chunk.size() > 1 ) 
+			std::swap( d_chunk.back(), d_chunk[ d_chunk.size()-2 ] );
+		else 
+			d_chunkSz = d_chunkCapacity; // nothing to bump from yet
+		d_bytesUsed += sz;
+		uintptr_t p = ( (uintptr_t)buf + align-1 ) & ~(uintptr_t)(align-1);
+		return (void*)p;
+	}
+	uintptr_t base = ( d_chunk.empty() ? 0 : (uintptr_t)d_chunk.back() );
+	uintptr_t p = ( (base + d_chunkSz + align-1) & ~(uintptr_t)(align-1) );
+	if( d_chunk.empty() || p + sz > base + d_chunkCapacity ) {
+		base = (uintptr_t)addNewChunk( d_chunkCapacity );
+		p = ( (base + align-1) & ~(uintptr_t)(align-1) );
+	}
+	d_chunkSz = (p + sz) - base;
+	d_bytesUsed += sz;
+	return (void*)p;
+}
+
+} // namespace yay
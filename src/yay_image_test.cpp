@@ -0,0 +1,186 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+
+/// binary image round trips: serialize -> attach (frozen trie, string pool, property index) 
+/// must answer every query the same way the in memory structure does. truncated images are rejected
+#include <random>
+#include <string>
+#include <yay/yay_trie_frozen.h>
+#include <yay/yay_string_pool_image.h>
+#include <yay/yay_index.h>
+#include "yay_test.h"
+
+namespace {
+
+enum : uint32_t { NO_VALUE = 0xffffffff };
+
+void testFrozenTrie()
+{
+	std::mt19937 rng(1);
+	yay::char_trie<uint32_t> t;
+	std::vector< std::string > words;
+	for( uint32_t i = 0; i< 20000; ++i ) {
+		std::string w;
+		for( size_t j = 0, len = 1+rng()%8; j< len; ++j ) 
+			w.push_back( (char)('a'+rng()%5) );
+		words.push_back( w );
+		t.add( w.c_str(), i, NO_VALUE );
+	}
+	yay::frozen_char_trie<uint32_t> f(t);
+	std::ostringstream fp;
+	YAY_TEST_CHECK( !f.serialize(fp) );
+	yay::test::aligned_image img( fp.str() );
+
+	yay::frozen_char_trie<uint32_t> m;
+	YAY_TEST_CHECK( !m.attach( img.data(), img.size() ) );
+	YAY_TEST_CHECK( !m.verify() );
+	YAY_TEST_CHECK( m.getNumNodes() == f.getNumNodes() );
+	for( int i = 0; i< 50000; ++i ) {
+		std::string w;
+		if( i%2 ) 
+			w = words[ rng()%words.size() ];
+		else {
+			for( size_t j = 0, len = rng()%10; j< len; ++j ) 
+				w.push_back( (char)('a'+rng()%6) );
+		}
+		std::pair< const yay::trie<char,uint32_t>*, const char* > x = t.matchString( w.c_str() );
+		std::pair< const yay::frozen_char_trie<uint32_t>::node*, const char* > y = m.matchString( w.c_str() );
+		YAY_TEST_CHECK( x.second == y.second );
+		YAY_TEST_CHECK( !x.first == !y.first );
+		if( x.first && y.first ) 
+			YAY_TEST_CHECK( x.first->data() == y.first->data() );
+	}
+	yay::frozen_char_trie<uint32_t> bad;
+	YAY_TEST_CHECK( bad.attach( img.data(), img.size()/2 ) );
+}
+
+void testStringPool( int poolFlags )
+{
+	const size_t sizes[] = { 0, 1, 5, 20000 };
+	for( size_t s = 0; s< sizeof(sizes)/sizeof(sizes[0]); ++s ) {
+		yay::UniqueCharPool p( yay::CharPool::DEFAULT_CHUNK_SIZE, poolFlags );
+		char buf[32];
+		for( size_t i = 0; i< sizes[s]; ++i ) {
+			sprintf( buf, "Str%zu", i*3 );
+			p.internIt( buf );
+		}
+		std::ostringstream fp;
+		YAY_TEST_CHECK( !yay::MappedUniqueCharPool::serialize( p, fp ) );
+		yay::test::aligned_image img( fp.str() );
+
+		yay::MappedUniqueCharPool m;
+		YAY_TEST_CHECK( !m.attach( img.data(), img.size() ) );
+		YAY_TEST_CHECK( !m.verify() );
+		YAY_TEST_CHECK( m.getMaxId() == sizes[s] );
+		YAY_TEST_CHECK( m.isCaseFold() == p.isCaseFold() );
+		for( size_t i = 0; i< sizes[s]; ++i ) {
+			sprintf( buf, "Str%zu", i*3 );
+			YAY_TEST_CHECK( m.getId(buf) == i );
+			YAY_TEST_CHECK( !strcmp( m.resolveId(i), buf ) );
+			YAY_TEST_CHECK( m.getLength(i) == strlen(buf) );
+			sprintf( buf, "sTR%zu", i*3 );
+			YAY_TEST_CHECK( m.getId(buf) == p.getId(buf) );
+			sprintf( buf, "Str%zu", i*3+1 );
+			YAY_TEST_CHECK( m.getId(buf) == yay::MappedUniqueCharPool::ID_NOTFOUND );
+		}
+		YAY_TEST_CHECK( !m.resolveId( sizes[s] ) );
+
+		yay::MappedUniqueCharPool bad;
+		YAY_TEST_CHECK( bad.attach( img.data(), img.size()/2 ) );
+	}
+}
+
+typedef yay::IdValIndex<double> DoubleIdx;
+
+std::vector< uint32_t > query( const DoubleIdx& x, double l, double r, uint32_t numDocs )
+{
+	std::vector< uint32_t > cand, out;
+	for( uint32_t d = 0; d< numDocs; d+= 3 ) 
+		cand.push_back( d );
+	x.filterInRange( cand, l, r, out );
+	x.iterateValue( [&]( const DoubleIdx::ValIdPair_t& p ) { 
+		out.push_back( p.second );
+		return true;
+	}, l, r );
+	for( uint32_t d = 0; d< numDocs; d+= 7 ) 
+		out.push_back( x.isInRange(d,l,r) );
+	return out;
+}
+
+void testPropIndex()
+{
+	enum : uint32_t { NUM_DOCS = 20000 };
+	std::mt19937 rng(1);
+	yay::IdPropValIndex<double> a;
+	for( int prop = 0; prop< 50; ++prop ) {
+		std::ostringstream nm;
+		nm << "prop_" << prop;
+		bool dense = ( prop%2 );
+		for( uint32_t d = 0, n = ( prop< 3 ? NUM_DOCS : 500 ); d< n; ++d ) {
+			if( !dense && rng()%2 ) 
+				continue;
+			a.append( nm.str(), dense ? d : d*2, rng()%1000 );
+		}
+	}
+	a.sort();
+	a.add( "prop_0", 7, 5.0 );
+	a.remove( "prop_1", 3 );
+	a.add( "prop_new", 1, 2.0 );
+
+	std::ostringstream fp;
+	YAY_TEST_CHECK( !a.serialize(fp) );
+	yay::test::aligned_image img( fp.str() );
+	yay::IdPropValIndex<double> b;
+	YAY_TEST_CHECK( !b.attach( img.data(), img.size() ) );
+	YAY_TEST_CHECK( !b.verify() );
+	YAY_TEST_CHECK( b.getNumProps() == a.getNumProps() );
+	for( int prop = 0; prop< 50; ++prop ) {
+		std::ostringstream nm;
+		nm << "prop_" << prop;
+		const DoubleIdx* x = a.getPropIdx( nm.str() ), *y = b.getPropIdx( nm.str() );
+		YAY_TEST_CHECK( y && y->isAttached() );
+		if( !x || !y ) 
+			continue;
+		for( int k = 0; k< 5; ++k ) {
+			double l = rng()%1000, r = l + rng()%50;
+			YAY_TEST_CHECK( query(*x,l,r,2*NUM_DOCS) == query(*y,l,r,2*NUM_DOCS) );
+		}
+	}
+	YAY_TEST_CHECK( b.getPropIdx("prop_new") && b.getPropIdx("prop_new")->isInRange(1,2,2) );
+
+	yay::IdPropValIndex<double> bad;
+	YAY_TEST_CHECK( bad.attach( img.data(), img.size()/2 ) );
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+	testFrozenTrie();
+	testStringPool( 0 );
+	testStringPool( yay::UniqueCharPool::POOL_CASE_FOLD );
+	testPropIndex();
+	return yay::test::exitCode();
+}
@@ -0,0 +1,225 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+
+/// IdValIndex / IdPropValIndex checks: parallel sort and bulk load against the serial sort, 
+/// range filters against brute force for every backend (NaN and mixed sign values included)
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+#include <type_traits>
+#include <yay/yay_index.h>
+#include "yay_test.h"
+
+namespace {
+
+typedef yay::IdValIndex<double> DoubleIdx;
+
+template <typename T>
+bool sameIndex( const yay::IdValIndex<T>& a, const yay::IdValIndex<T>& b )
+{
+	size_t n = a.getNumSortedRows();
+	if( n != b.getNumSortedRows() || a.isDense() != b.isDense() ) 
+		return false;
+	for( size_t i = 0; i< n; ++i ) {
+		if( !(a.getValueColumn()[i] == b.getValueColumn()[i]) || a.getValueOrder()[i] != b.getValueOrder()[i] ) 
+			return false;
+		if( !a.isDense() && a.getIdColumn()[i] != b.getIdColumn()[i] ) 
+			return false;
+	}
+	return true;
+}
+
+/// serial sort, parallel sort and bulk load of pre sorted runs produce the same index
+void testParallelBuild()
+{
+	std::mt19937 rng(1);
+	const size_t threads[] = { 1, 2, 3, 8 };
+	for( int dense = 0; dense< 2; ++dense ) {
+		for( size_t t = 0; t< sizeof(threads)/sizeof(threads[0]); ++t ) {
+			DoubleIdx serial, parallel, loaded;
+			std::vector< std::vector< DoubleIdx::ValIdPair_t > > runs(7);
+			for( uint32_t d = 0; d< 60000; ++d ) {
+				if( !dense && !(d%3) ) 
+					continue;
+				int k = ( dense ? 1 : 1+rng()%2 );
+				for( int j = 0; j< k; ++j ) {
+					double v = rng()%5000;
+					serial.append( d, v );
+					runs[ rng()%runs.size() ].push_back( DoubleIdx::ValIdPair_t(v,d) );
+				}
+			}
+			for( size_t r = 0; r< runs.size(); ++r ) {
+				std::sort( runs[r].begin(), runs[r].end(), DoubleIdx::compare_less_byid() );
+				for( size_t i = 0; i< runs[r].size(); ++i ) 
+					parallel.append( runs[r][i].second, runs[r][i].first );
+			}
+			serial.sort();
+			parallel.sort( threads[t] );
+			loaded.bulkLoad( runs, threads[t] );
+			YAY_TEST_CHECK( sameIndex(serial,parallel) );
+			YAY_TEST_CHECK( sameIndex(serial,loaded) );
+		}
+	}
+	DoubleIdx empty;
+	empty.bulkLoad( std::vector< std::vector< DoubleIdx::ValIdPair_t > >(), 4 );
+	YAY_TEST_CHECK( !empty.isInRange(0,-1,1) );
+
+	yay::IdPropValIndex<double> p1, p2;
+	for( int prop = 0; prop< 40; ++prop ) {
+		std::ostringstream nm;
+		nm << "p" << prop;
+		size_t n = ( prop< 2 ? 50000 : 2000 );
+		for( size_t d = 0; d< n; ++d ) {
+			double v = rng()%100000;
+			uint32_t id = rng()%(2*n);
+			p1.append( nm.str(), id, v );
+			p2.append( nm.str(), id, v );
+		}
+	}
+	p1.sort();
+	p2.sort(4);
+	for( int prop = 0; prop< 40; ++prop ) {
+		std::ostringstream nm;
+		nm << "p" << prop;
+		YAY_TEST_CHECK( sameIndex( *(p1.getPropIdx(nm.str())), *(p2.getPropIdx(nm.str())) ) );
+	}
+}
+
+/// random value in [-1000,1000) for signed types, around the sign bit (0x80000000) for unsigned ones
+template <typename T>
+T randomValue( std::mt19937& rng )
+{
+	return ( std::is_unsigned<T>::value ? (T)(rng()%2000+0x7ffff000u) : (T)((int)(rng()%2000)-1000) );
+}
+
+/// isInRange, filterInRange and filterBitmapInRange against a brute force scan 
+template <typename T>
+void testRangeFilters( int seed )
+{
+	enum : uint32_t { NUM_DOCS = 20000 };
+	std::mt19937 rng(seed);
+	yay::IdValIndex<T> idx;
+	std::vector< std::set<T> > vals(NUM_DOCS);
+	for( int i = 0; i< 50000; ++i ) {
+		uint32_t d = rng()%NUM_DOCS;
+		T v = randomValue<T>(rng);
+		if( vals[d].insert(v).second ) 
+			idx.append( d, v );
+	}
+	idx.sort();
+	for( int q = 0; q< 40; ++q ) {
+		T l = randomValue<T>(rng), r = l + (T)(rng()%300);
+		std::vector< uint32_t > cand;
+		std::vector< uint64_t > bits( NUM_DOCS/64+1 );
+		for( uint32_t d = 0; d< NUM_DOCS+10; ++d ) {
+			if( rng()%( q%3 ? 2 : 50 ) ) 
+				continue;
+			cand.push_back( d );
+			if( d< NUM_DOCS ) 
+				bits[d>>6] |= (1ULL<<(d&63));
+		}
+		std::vector< uint32_t > expected, filtered, bitmapFiltered;
+		for( size_t c = 0; c< cand.size(); ++c ) {
+			uint32_t d = cand[c];
+			bool in = false;
+			if( d< NUM_DOCS ) {
+				for( typename std::set<T>::const_iterator v = vals[d].begin(); v != vals[d].end(); ++v ) 
+					in |= ( l <= *v && *v <= r );
+			}
+			if( in ) 
+				expected.push_back( d );
+			YAY_TEST_CHECK( idx.isInRange(d,l,r) == in );
+		}
+		idx.filterInRange( cand, l, r, filtered );
+		idx.filterBitmapInRange( &(bits[0]), NUM_DOCS, l, r, bitmapFiltered );
+		YAY_TEST_CHECK( filtered == expected );
+		YAY_TEST_CHECK( bitmapFiltered == expected );
+	}
+}
+
+/// NaN is never in range - not even in [-inf,+inf]
+void testNaN()
+{
+	const double inf = std::numeric_limits<double>::infinity();
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	DoubleIdx x;
+	size_t numNumbers = 0;
+	std::vector< uint32_t > cand, expected;
+	for( uint32_t i = 0; i< 200; ++i ) {
+		bool isNan = ( i%7 == 3 );
+		x.append( i, isNan ? nan : (double)i-100 );
+		cand.push_back( i );
+		if( !isNan ) {
+			expected.push_back( i );
+			++numNumbers;
+		}
+	}
+	x.sort();
+
+	std::vector< uint32_t > filtered, bitmapFiltered;
+	x.filterInRange( cand, -inf, inf, filtered );
+	YAY_TEST_CHECK( filtered == expected );
+
+	std::vector< uint64_t > bits( 200/64+1, ~0ULL );
+	x.filterBitmapInRange( &(bits[0]), 200, -inf, inf, bitmapFiltered );
+	YAY_TEST_CHECK( bitmapFiltered == expected );
+
+	size_t numIterated = 0, numNan = 0;
+	x.iterateValue( [&]( const DoubleIdx::ValIdPair_t& p ) { 
+		numNan += ( p.first != p.first );
+		++numIterated;
+		return true;
+	}, -inf, inf );
+	YAY_TEST_CHECK( numIterated == numNumbers );
+	YAY_TEST_CHECK( !numNan );
+
+	size_t numInRange = 0;
+	for( uint32_t i = 0; i< 200; ++i ) 
+		numInRange += x.isInRange( i, -inf, inf );
+	YAY_TEST_CHECK( numInRange == numNumbers );
+	YAY_TEST_CHECK( !x.isInRange( 3, -inf, inf ) );
+
+	// delta layer
+	x.add( 500, nan );
+	x.add( 501, 1.0 );
+	YAY_TEST_CHECK( !x.isInRange( 500, -inf, inf ) );
+	YAY_TEST_CHECK( x.isInRange( 501, -inf, inf ) );
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+	testParallelBuild();
+	testRangeFilters<double>(1);
+	testRangeFilters<float>(2);
+	testRangeFilters<int32_t>(3);
+	testRangeFilters<uint32_t>(4);
+	testRangeFilters<int64_t>(5);
+	testNaN();
+	return yay::test::exitCode();
+}
@@ -0,0 +1,64 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#include <yay/yay_mmap.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace yay {
+
+int mmap_file::open( const char* path )
+{
+	close();
+	int fd = ::open( path, O_RDONLY );
+	if( fd < 0 ) 
+		return -1;
+
+	struct stat st;
+	if( fstat( fd, &st ) || !st.st_size ) {
+		::close(fd);
+		return -1;
+	}
+	void* addr = mmap( 0, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	::close(fd);
+	if( addr == MAP_FAILED ) 
+		return -1;
+
+	d_buf = (const char*)addr;
+	d_sz = st.st_size;
+	return 0;
+}
+
+void mmap_file::close()
+{
+	if( d_buf ) {
+		munmap( (void*)d_buf, d_sz );
+		d_buf = 0;
+		d_sz = 0;
+	}
+}
+
+} // namespace yay
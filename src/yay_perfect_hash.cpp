@@ -0,0 +1,104 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#include <yay/yay_perfect_hash.h>
+
+namespace yay {
+
+int perfect_hash::build( const uint64_t* h, size_t n )
+{
+	clear();
+	if( !n ) 
+		return 0;
+	{ // duplicates would never be placed
+		std::vector< uint64_t > sorted( h, h+n );
+		std::sort( sorted.begin(), sorted.end() );
+		if( std::adjacent_find( sorted.begin(), sorted.end() ) != sorted.end() ) 
+			return -1;
+	}
+	size_t numBuckets = ( n + DEFAULT_BUCKET_LOAD-1 ) / DEFAULT_BUCKET_LOAD;
+	d_pilot.assign( numBuckets, 0 );
+	d_numSlots = n + n/100 + 1;
+
+	// keys grouped by bucket (counting sort)
+	std::vector< uint32_t > bucketStart( numBuckets+1, 0 );
+	for( size_t i = 0; i< n; ++i ) 
+		++bucketStart[ bucket(h[i])+1 ];
+	size_t maxBucketSz = 0;
+	for( size_t b = 0; b< numBuckets; ++b ) {
+		if( maxBucketSz < bucketStart[b+1] ) 
+			maxBucketSz = bucketStart[b+1];
+		bucketStart[b+1] += bucketStart[b];
+	}
+	std::vector< uint64_t > key( n );
+	{
+		std::vector< uint32_t > fill( bucketStart.begin(), bucketStart.end()-1 );
+		for( size_t i = 0; i< n; ++i ) 
+			key[ fill[ bucket(h[i]) ]++ ] = h[i];
+	}
+	// buckets biggest first (counting sort by size)
+	std::vector< uint32_t > order( numBuckets );
+	{
+		std::vector< uint32_t > sizeStart( maxBucketSz+2, 0 );
+		for( size_t b = 0; b< numBuckets; ++b ) 
+			++sizeStart[ maxBucketSz - (bucketStart[b+1]-bucketStart[b]) + 1 ];
+		for( size_t s = 0; s<= maxBucketSz; ++s ) 
+			sizeStart[s+1] += sizeStart[s];
+		for( size_t b = 0; b< numBuckets; ++b ) 
+			order[ sizeStart[ maxBucketSz - (bucketStart[b+1]-bucketStart[b]) ]++ ] = b;
+	}
+
+	enum : uint32_t { MAX_PILOT = (1<<24) };
+	std::vector< uint8_t > taken( d_numSlots, 0 );
+	std::vector< size_t > pos( maxBucketSz );
+	for( size_t o = 0; o< numBuckets; ++o ) {
+		size_t b = order[o];
+		const uint64_t* k = &(key[0]) + bucketStart[b];
+		size_t k_sz = bucketStart[b+1]-bucketStart[b];
+		if( !k_sz ) 
+			break; // all the rest are empty too
+		uint32_t pilot = 0;
+		for( ; pilot < MAX_PILOT; ++pilot ) {
+			size_t j = 0;
+			for( ; j< k_sz; ++j ) {
+				pos[j] = slot( k[j], pilot );
+				if( taken[ pos[j] ] ) 
+					break;
+				taken[ pos[j] ] = 1; // marked right away to catch collisions inside the bucket
+			}
+			if( j == k_sz ) 
+				break;
+			while( j-- ) 
+				taken[ pos[j] ] = 0;
+		}
+		if( pilot == MAX_PILOT ) {
+			clear();
+			return -1;
+		}
+		d_pilot[b] = pilot;
+	}
+	return 0;
+}
+
+} // namespace yay
@@ -0,0 +1,193 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#include <yay/yay_string_dict.h>
+#include <algorithm>
+
+namespace yay {
+
+namespace {
+
+/// byte-wise comparison, same order as memcmp
+inline int compareSpan( const char* l, size_t l_sz, const char* r, size_t r_sz )
+{
+	int rc = memcmp( l, r, std::min(l_sz,r_sz) );
+	return ( rc ? rc : ( l_sz < r_sz ? -1 : (r_sz < l_sz ? 1 : 0) ) );
+}
+struct span_less {
+	bool operator()( const char_span& l, const char_span& r ) const 
+		{ return compareSpan( l.data(), l.size(), r.data(), r.size() ) < 0; }
+};
+
+} // anonymous namespace 
+
+FrontCodedStringDict::FrontCodedStringDict( size_t bucketSz ) : 
+	d_bucketSz( bucketSz ? bucketSz : 1 ),
+	d_numStrings(0)
+{}
+
+void FrontCodedStringDict::clear()
+{
+	d_data.clear();
+	d_bucket.clear();
+	d_numStrings = 0;
+}
+
+void FrontCodedStringDict::build( const std::vector< std::string >& strs )
+{
+	std::vector< char_span > v;
+	v.reserve( strs.size() );
+	for( std::vector< std::string >::const_iterator i = strs.begin(); i!= strs.end(); ++i ) 
+		v.push_back( char_span(*i) );
+	build( v );
+}
+
+void FrontCodedStringDict::build( const std::vector< char_span >& strs )
+{
+	clear();
+	std::vector< char_span > v( strs );
+	std::sort( v.begin(), v.end(), span_less() );
+	v.erase( std::unique( v.begin(), v.end() ), v.end() );
+
+	const char_span* prev = 0;
+	for( std::vector< char_span >::const_iterator i = v.begin(); i!= v.end(); ++i ) {
+		if( d_numStrings % d_bucketSz == 0 ) {
+			d_bucket.push_back( d_data.size() );
+			frontcoded::writeVarint( d_data, i->size() );
+			d_data.insert( d_data.end(), i->begin(), i->end() );
+		} else {
+			size_t lcp = 0, maxLcp = std::min( prev->size(), i->size() );
+			while( lcp < maxLcp && prev->data()[lcp] == i->data()[lcp] ) 
+				++lcp;
+			frontcoded::writeVarint( d_data, lcp );
+			frontcoded::writeVarint( d_data, i->size()-lcp );
+			d_data.insert( d_data.end(), i->begin()+lcp, i->end() );
+		}
+		prev = &(*i);
+		++d_numStrings;
+	}
+	std::vector< uint8_t >( d_data ).swap( d_data );
+	std::vector< uint64_t >( d_bucket ).swap( d_bucket );
+}
+
+char_span FrontCodedStringDict::getHead( size_t b, const uint8_t*& next ) const
+{
+	uint64_t len;
+	const uint8_t* p = frontcoded::readVarint( &(d_data[ d_bucket[b] ]), len );
+	next = p+len;
+	return char_span( (const char*)p, len );
+}
+
+size_t FrontCodedStringDict::upperBucket( const char_span& s ) const
+{
+	size_t lo = 0, hi = d_bucket.size();
+	while( lo < hi ) {
+		size_t mid = (lo+hi)/2;
+		const uint8_t* next;
+		char_span h = getHead( mid, next );
+		if( compareSpan( h.data(), h.size(), s.data(), s.size() ) <= 0 ) 
+			lo = mid+1;
+		else 
+			hi = mid;
+	}
+	return lo;
+}
+
+bool FrontCodedStringDict::decode( StrId id, std::string& s ) const
+{
+	if( id >= d_numStrings ) 
+		return false;
+	forEach( id, id+1, [&s]( StrId, const std::string& x ) { s = x; return false; } );
+	return true;
+}
+
+/// scans the bucket without materializing strings. m is how much of s the previous string matched.
+/// strings are sorted so an entry sharing less than m with its predecessor is already past s
+FrontCodedStringDict::StrId FrontCodedStringDict::getId( const char_span& s ) const
+{
+	size_t b = upperBucket( s );
+	if( !b ) 
+		return ID_NOTFOUND;
+	--b;
+	const uint8_t* p;
+	char_span h = getHead( b, p );
+	size_t m = 0, curLen = h.size();
+	while( m < h.size() && m < s.size() && h.data()[m] == s.data()[m] ) 
+		++m;
+	StrId id = b*d_bucketSz;
+	StrId id_end = std::min( (StrId)(id+d_bucketSz), (StrId)d_numStrings );
+	while( true ) {
+		if( m == s.size() && m == curLen ) 
+			return id;
+		if( ++id >= id_end ) 
+			return ID_NOTFOUND;
+		uint64_t lcp, sufLen;
+		p = frontcoded::readVarint( p, lcp );
+		p = frontcoded::readVarint( p, sufLen );
+		const uint8_t* suf = p;
+		p += sufLen;
+		curLen = lcp + sufLen;
+		if( lcp < m ) // differs from s at lcp where previous string was equal to s - it's greater
+			return ID_NOTFOUND;
+		else if( lcp > m ) // same as previous at m - still less than s
+			continue;
+		size_t j = 0;
+		for( ; j< sufLen && m < s.size() && (char)suf[j] == s.data()[m]; ++j ) 
+			++m;
+		if( j < sufLen && ( m == s.size() || suf[j] > (uint8_t)s.data()[m] ) ) // past s
+			return ID_NOTFOUND;
+	}
+}
+
+FrontCodedStringDict::StrId FrontCodedStringDict::lowerBound( const char_span& s ) const
+{
+	size_t b = upperBucket( s );
+	if( !b ) 
+		return 0;
+	--b;
+	StrId res = std::min( (StrId)((b+1)*d_bucketSz), (StrId)d_numStrings );
+	forEach( b*d_bucketSz, res, [&]( StrId id, const std::string& x ) {
+		if( compareSpan( x.data(), x.size(), s.data(), s.size() ) >= 0 ) {
+			res = id;
+			return false;
+		}
+		return true;
+	} );
+	return res;
+}
+
+std::pair< FrontCodedStringDict::StrId, FrontCodedStringDict::StrId > FrontCodedStringDict::prefixRange( const char_span& prefix ) const
+{
+	StrId first = lowerBound( prefix );
+	// everything starting with prefix is less than prefix with the last incrementable byte incremented
+	std::string next( prefix.data(), prefix.size() );
+	while( !next.empty() && (uint8_t)next.back() == 0xff ) 
+		next.pop_back();
+	if( next.empty() ) 
+		return std::pair< StrId, StrId >( first, d_numStrings );
+	next.back() = (char)( (uint8_t)next.back()+1 );
+	return std::pair< StrId, StrId >( first, lowerBound(next) );
+}
+
+} // namespace yay
@@ -24,58 +24,192 @@ THE SOFTWARE.
 
 #include <yay/yay_string_pool.h>
 #include <iostream>
+#include <sys/mman.h>
 
 namespace yay {
 
-void CharPool::clear() 
+namespace {
+enum : size_t { HUGE_PAGE_SZ = 2*1024*1024 };
+}
+
+CharPool::Chunk CharPool::allocChunk( size_t sz ) const
 {
-	for( ChunkVec::iterator i = chunk.begin(); i!= chunk.end(); ++i ) {
-		free( *i );
-		*i=0;
+	Chunk c = { 0, sz, false };
+	if( flags & POOL_HUGE_PAGES ) {
+		c.capacity = ( (sz + HUGE_PAGE_SZ-1) & ~(size_t)(HUGE_PAGE_SZ-1) );
+		void* p = mmap( 0, c.capacity, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0 );
+		if( p == MAP_FAILED ) { // no reserved huge pages - asking for transparent ones
+			p = mmap( 0, c.capacity, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0 );
+			if( p != MAP_FAILED ) 
+				madvise( p, c.capacity, MADV_HUGEPAGE );
+		}
+		if( p != MAP_FAILED ) {
+			c.buf = (char*)p;
+			c.isMmapped = true;
+			return c;
+		}
+		c.capacity = sz;
 	}
+	c.buf = (char*)malloc( c.capacity );
+	if( !(flags & POOL_ARENA) ) // legacy pools always handed out zeroed memory
+		memset( c.buf, 0, c.capacity );
+	return c;
+}
+
+void CharPool::freeChunk( Chunk& c ) const
+{
+	if( c.isMmapped ) 
+		munmap( c.buf, c.capacity );
+	else
+		free( c.buf );
+	c.buf = 0;
+}
+
+void CharPool::release() 
+{
+	for( ChunkVec::iterator i = chunk.begin(); i!= chunk.end(); ++i ) 
+		freeChunk( *i );
 	chunk.clear();
+	curChunk = 0;
+	chunkSz = 0;
+	bytesUsed = 0;
+	bytesReserved = 0;
+}
+
+void CharPool::clear() 
+{
+	if( flags & POOL_ARENA ) {
+		curChunk = 0;
+		chunkSz = 0;
+		bytesUsed = 0;
+	} else 
+		release();
 }
 
 CharPool::~CharPool( )
 {
-	clear();
+	release();
 }
 
-CharPool::CharPool( size_t cSz ) : 
+CharPool::CharPool( size_t cSz, int poolFlags ) : 
 	chunkCapacity(cSz),
-	chunkSz(0)
+	chunkSz(0),
+	curChunk(0),
+	flags(poolFlags),
+	bytesUsed(0),
+	highWater(0),
+	bytesReserved(0)
 {
 	addNewChunk();
 }
 
+/// new chunk goes right after the current one and becomes current
 char* CharPool::addNewChunk( )
 {
-	chunk.resize( chunk.size() + 1 );
-
-	chunk.back() = (char*)malloc( chunkCapacity );
-	memset( chunk.back(), 0, chunkCapacity );
+	Chunk c = allocChunk( chunkCapacity );
+	if( chunk.empty() ) 
+		curChunk = 0;
+	else 
+		++curChunk;
+	chunk.insert( chunk.begin()+curChunk, c );
+	bytesReserved += c.capacity;
 	chunkSz = 0;
-	return chunk.back();
+	return c.buf;
 }
 
-const char* CharPool::addStringToPool( const char* s, size_t len )
+void* CharPool::alloc( size_t sz, size_t align )
 {
-	if( chunkCapacity < chunkSz + len )
-	{
-		if( chunkCapacity < len)
-			chunkCapacity = len;
-		addNewChunk();
+	while( true ) {
+		if( curChunk < chunk.size() ) {
+			const Chunk& c = chunk[curChunk];
+			uintptr_t base = (uintptr_t)c.buf;
+			uintptr_t p = ( (base + chunkSz + align-1) & ~(uintptr_t)(align-1) );
+			if( p + sz <= base + c.capacity ) {
+				chunkSz = (p + sz) - base;
+				bytesUsed += sz;
+				if( highWater < bytesUsed ) 
+					highWater = bytesUsed;
+				return (void*)p;
+			}
+		}
+		// current chunk is full (or there's none after clear) 
+		size_t minSz = sz + align-1;
+		if( curChunk+1 < chunk.size() && chunk[curChunk+1].capacity >= minSz ) { // arena - reusing
+			++curChunk;
+			chunkSz = 0;
+		} else {
+			if( chunkCapacity < minSz )
+				chunkCapacity = minSz;
+			addNewChunk();
+		}
 	}
+}
 
-	char* backVec = chunk.back();
-	
-	size_t loc = chunkSz;
-	chunkSz += len; 
-	
-	char* locStr = backVec+loc;
+const char* CharPool::addStringToPool( const char* s, size_t len )
+{
+	char* locStr = allocInPool( len );
+	memcpy( locStr, s, len );
+	return locStr;
+}
 
+const char* CharPool::addSpanToPool( const char* s, size_t len )
+{
+	char* locStr = allocInPool( len+1 );
 	memcpy( locStr, s, len );
+	locStr[len] = 0;
 	return locStr;
 }
 
+int UniqueCharPool::freeze()
+{
+	if( frozen ) 
+		return 0;
+	std::vector< uint64_t > h( idVec.size() );
+	for( size_t id = 0; id< idVec.size(); ++id ) 
+		h[id] = keyHash( idVec[id], idLen[id] );
+	if( mph.build( h.empty() ? 0 : &(h[0]), h.size() ) ) 
+		return -1;
+	FrozenSlot empty = { 0, ID_NOTFOUND, 0 };
+	mphSlot.assign( mph.getNumSlots(), empty );
+	for( size_t id = 0; id< h.size(); ++id ) {
+		FrozenSlot& slot = mphSlot[ mph(h[id]) ];
+		slot.str = idVec[id];
+		slot.id = id;
+		slot.hash = (uint32_t)( h[id] ^ (h[id]>>32) );
+	}
+
+	IdSlotVec().swap( idSlot );
+	frozen = true;
+	return 0;
+}
+
+void UniqueCharPool::thaw()
+{
+	if( !frozen ) 
+		return;
+	size_t numSlots = 16;
+	while( numSlots < 2*(idVec.size()+1) ) 
+		numSlots <<= 1;
+	IdSlot empty = { ID_NOTFOUND, 0 };
+	idSlot.assign( numSlots, empty );
+	for( size_t id = 0; id< idVec.size(); ++id ) {
+		uint32_t hash = slotHash( idVec[id], idLen[id] );
+		size_t j = hash & (numSlots-1);
+		while( idSlot[j].id != ID_NOTFOUND ) 
+			j = (j+1) & (numSlots-1);
+		idSlot[j].id = id;
+		idSlot[j].hash = hash;
+	}
+	mph.clear();
+	FrozenSlotVec().swap( mphSlot );
+	frozen = false;
+}
+
+void UniqueCharPool::rebuildBloomFilter( size_t capacity, double fpRate )
+{
+	bloom.init( std::max( capacity, (size_t)1024 ), fpRate );
+	for( size_t id = 0; id< idVec.size(); ++id ) 
+		bloom.add( keyHash( idVec[id], idLen[id] ) );
+}
+
 }
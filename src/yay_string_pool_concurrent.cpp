@@ -0,0 +1,117 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#include <yay/yay_string_pool_concurrent.h>
+
+namespace yay {
+
+ConcurrentUniqueCharPool::ConcurrentUniqueCharPool( size_t numShards, size_t cSz ) : 
+	d_dir( new std::atomic<DirEntry*>[DIR_MAX_CHUNKS] ),
+	d_nextId(0)
+{
+	size_t n = 1;
+	while( n < numShards ) 
+		n <<= 1;
+	d_shardMask = n-1;
+	d_shard.reset( new std::unique_ptr<Shard>[n] );
+	for( size_t i = 0; i< n; ++i ) 
+		d_shard[i].reset( new Shard(cSz) );
+	for( size_t i = 0; i< DIR_MAX_CHUNKS; ++i ) 
+		d_dir[i].store( 0, std::memory_order_relaxed );
+}
+
+ConcurrentUniqueCharPool::~ConcurrentUniqueCharPool()
+{
+	for( size_t i = 0; i< DIR_MAX_CHUNKS; ++i ) 
+		delete [] d_dir[i].load( std::memory_order_relaxed );
+}
+
+void ConcurrentUniqueCharPool::clear()
+{
+	for( size_t i = 0; i<= d_shardMask; ++i ) {
+		d_shard[i]->idMap.clear();
+		d_shard[i]->pool.clear();
+	}
+	for( size_t i = 0; i< DIR_MAX_CHUNKS; ++i ) {
+		delete [] d_dir[i].load( std::memory_order_relaxed );
+		d_dir[i].store( 0, std::memory_order_relaxed );
+	}
+	d_nextId.store( 0 );
+}
+
+/// chunks are created on demand. two shards can race for the same chunk - the loser throws its copy away
+ConcurrentUniqueCharPool::DirEntry* ConcurrentUniqueCharPool::getDirChunk( uint32_t id )
+{
+	std::atomic<DirEntry*>& slot = d_dir[ id>>DIR_CHUNK_BITS ];
+	DirEntry* chunk = slot.load( std::memory_order_acquire );
+	if( chunk ) 
+		return chunk;
+
+	DirEntry* newChunk = new DirEntry[DIR_CHUNK_SZ];
+	for( size_t i = 0; i< DIR_CHUNK_SZ; ++i ) 
+		newChunk[i].store( 0, std::memory_order_relaxed );
+	if( slot.compare_exchange_strong( chunk, newChunk, std::memory_order_acq_rel ) ) 
+		return newChunk;
+	delete [] newChunk;
+	return chunk;
+}
+
+/// sh must be locked
+ConcurrentUniqueCharPool::StrId ConcurrentUniqueCharPool::internInShard( Shard& sh, const HashedStr& key )
+{
+	CharIdMap::const_iterator i = sh.idMap.find( key );
+	if( i != sh.idMap.end() ) 
+		return i->second;
+
+	// ids never wrap - once ID_NOTFOUND is reached interning fails
+	StrId id = d_nextId.load( std::memory_order_relaxed );
+	do {
+		if( id >= ID_NOTFOUND ) 
+			return ID_NOTFOUND;
+	} while( !d_nextId.compare_exchange_weak( id, id+1, std::memory_order_acq_rel ) );
+
+	const char* newS = sh.pool.addSpanToPool( key.str, key.len );
+	getDirChunk(id)[ id & (DIR_CHUNK_SZ-1) ].store( newS, std::memory_order_release );
+	sh.idMap.insert( CharIdMap::value_type(HashedStr(newS,key.len,key.hash), id) );
+	return id;
+}
+
+ConcurrentUniqueCharPool::StrId ConcurrentUniqueCharPool::internIt( const char* s, size_t s_len )
+{
+	HashedStr key( s, s_len );
+	Shard& sh = getShard( key.hash );
+	std::lock_guard<std::mutex> lock( sh.mtx );
+	return internInShard( sh, key );
+}
+
+ConcurrentUniqueCharPool::StrId ConcurrentUniqueCharPool::getId( const char* s, size_t s_len ) const
+{
+	HashedStr key( s, s_len );
+	Shard& sh = getShard( key.hash );
+	std::lock_guard<std::mutex> lock( sh.mtx );
+	CharIdMap::const_iterator i = sh.idMap.find( key );
+	return ( i == sh.idMap.end() ? (StrId)ID_NOTFOUND : i->second );
+}
+
+} // namespace yay
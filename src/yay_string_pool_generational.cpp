@@ -0,0 +1,228 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#include <yay/yay_string_pool_generational.h>
+#include <thread>
+
+namespace yay {
+
+GenerationalCharPool::GenerationalCharPool( size_t cSz ) : 
+	d_freeId(ID_NOTFOUND),
+	d_numLive(0),
+	d_chunkSz(cSz),
+	d_epoch(1)
+{
+	for( size_t i = 0; i< MAX_READERS; ++i ) 
+		d_reader[i].store( 0, std::memory_order_relaxed );
+	clear();
+}
+
+GenerationalCharPool::~GenerationalCharPool()
+{}
+
+void GenerationalCharPool::clear()
+{
+	d_entry.clear();
+	d_freeId = ID_NOTFOUND;
+	d_numLive = 0;
+	IdSlot empty = { ID_NOTFOUND, 0 };
+	d_slot.assign( 16, empty );
+	d_gen.clear();
+	d_retired.clear();
+	GenPool g;
+	g.gen = 0;
+	g.pool.reset( new CharPool(d_chunkSz) );
+	d_gen.push_back( std::move(g) );
+}
+
+size_t GenerationalCharPool::enterRead() const
+{
+	while( true ) {
+		for( size_t i = 0; i< MAX_READERS; ++i ) {
+			uint64_t expected = 0;
+			if( d_reader[i].compare_exchange_strong( expected, d_epoch.load() ) ) 
+				return i;
+		}
+		std::this_thread::yield(); // all slots taken - wait for a reader to leave
+	}
+}
+
+size_t GenerationalCharPool::reclaim()
+{
+	uint64_t minEpoch = ~(uint64_t)0;
+	for( size_t i = 0; i< MAX_READERS; ++i ) {
+		uint64_t e = d_reader[i].load();
+		if( e && e < minEpoch ) 
+			minEpoch = e;
+	}
+	size_t numFreed = 0;
+	for( size_t i = 0; i< d_retired.size(); ) {
+		if( d_retired[i].epoch < minEpoch ) {
+			d_retired[i] = std::move( d_retired.back() );
+			d_retired.pop_back();
+			++numFreed;
+		} else 
+			++i;
+	}
+	return numFreed;
+}
+
+void GenerationalCharPool::rebuildIndex()
+{
+	size_t numSlots = 16;
+	while( numSlots < 2*(d_numLive+1) ) 
+		numSlots <<= 1;
+	std::vector< IdSlot > old;
+	IdSlot empty = { ID_NOTFOUND, 0 };
+	old.swap( d_slot );
+	d_slot.assign( numSlots, empty );
+	size_t mask = numSlots-1;
+	for( std::vector< IdSlot >::const_iterator i = old.begin(); i!= old.end(); ++i ) {
+		if( i->id == ID_NOTFOUND ) 
+			continue;
+		size_t j = i->hash & mask;
+		while( d_slot[j].id != ID_NOTFOUND ) 
+			j = (j+1) & mask;
+		d_slot[j] = *i;
+	}
+}
+
+void GenerationalCharPool::eraseFromIndex( StrId id )
+{
+	const Entry& e = d_entry[id];
+	size_t mask = d_slot.size()-1;
+	size_t i = slotHash( e.str, e.len ) & mask;
+	while( d_slot[i].id != id ) 
+		i = (i+1) & mask;
+	// backward shift - pull later entries of the cluster into the hole unless their home slot 
+	// lies after the hole
+	for( size_t j = (i+1) & mask; d_slot[j].id != ID_NOTFOUND; j = (j+1) & mask ) {
+		size_t home = d_slot[j].hash & mask;
+		if( ( (j-home) & mask ) >= ( (j-i) & mask ) ) {
+			d_slot[i] = d_slot[j];
+			i = j;
+		}
+	}
+	d_slot[i].id = ID_NOTFOUND;
+	d_slot[i].hash = 0;
+}
+
+GenerationalCharPool::StrId GenerationalCharPool::internIt( const char* s, size_t s_len )
+{
+	if( 2*(d_numLive+1) > d_slot.size() ) 
+		rebuildIndex();
+	uint32_t h = slotHash( s, s_len );
+	IdSlot& slot = d_slot[ findSlot(s,s_len,h) ];
+	if( slot.id != ID_NOTFOUND ) {
+		d_entry[ slot.id ].gen = getGeneration();
+		return slot.id;
+	}
+
+	StrId id;
+	if( d_freeId != ID_NOTFOUND ) {
+		id = d_freeId;
+		d_freeId = d_entry[id].len;
+	} else {
+		id = d_entry.size();
+		d_entry.push_back( Entry() );
+	}
+	Entry& e = d_entry[id];
+	e.str = curPool().addSpanToPool( s, s_len );
+	e.len = s_len;
+	e.gen = e.home = getGeneration();
+	slot.id = id;
+	slot.hash = h;
+	++d_numLive;
+	return id;
+}
+
+GenerationalCharPool::Generation GenerationalCharPool::newGeneration()
+{
+	GenPool g;
+	g.gen = getGeneration()+1;
+	g.pool.reset( new CharPool(d_chunkSz) );
+	d_gen.push_back( std::move(g) );
+	return d_gen.back().gen;
+}
+
+size_t GenerationalCharPool::retireGenerations( Generation keepFrom )
+{
+	if( keepFrom > getGeneration() ) 
+		keepFrom = getGeneration();
+	if( d_gen.front().gen >= keepFrom ) 
+		return 0;
+
+	size_t numForgotten = 0;
+	for( StrId id = 0; id< d_entry.size(); ++id ) {
+		Entry& e = d_entry[id];
+		if( !e.str ) 
+			continue;
+		if( e.gen < keepFrom ) {
+			eraseFromIndex( id );
+			e.str = 0;
+			e.len = d_freeId;
+			d_freeId = id;
+			--d_numLive;
+			++numForgotten;
+		} else if( e.home < keepFrom ) {
+			e.str = curPool().addSpanToPool( e.str, e.len );
+			e.home = getGeneration();
+		}
+	}
+	// index doesnt stay at its peak size after a big purge
+	if( d_slot.size() > 16 && 8*d_numLive < d_slot.size() ) 
+		rebuildIndex();
+
+	// readers which entered before this point may still hold strings from the old pools
+	uint64_t epoch = d_epoch.fetch_add( 1 );
+	while( d_gen.front().gen < keepFrom ) {
+		RetiredPool r;
+		r.epoch = epoch;
+		r.pool = std::move( d_gen.front().pool );
+		d_retired.push_back( std::move(r) );
+		d_gen.pop_front();
+	}
+	reclaim();
+	return numForgotten;
+}
+
+size_t GenerationalCharPool::advance( size_t numKeep )
+{
+	Generation g = newGeneration();
+	if( !numKeep ) 
+		numKeep = 1;
+	return retireGenerations( g+1 >= numKeep ? g+1-numKeep : 0 );
+}
+
+size_t GenerationalCharPool::getMemoryUsage() const
+{
+	size_t sz = d_slot.capacity()*sizeof(IdSlot) + d_entry.capacity()*sizeof(Entry);
+	for( std::deque< GenPool >::const_iterator i = d_gen.begin(); i!= d_gen.end(); ++i ) 
+		sz += i->pool->getBytesReserved();
+	for( std::vector< RetiredPool >::const_iterator i = d_retired.begin(); i!= d_retired.end(); ++i ) 
+		sz += i->pool->getBytesReserved();
+	return sz;
+}
+
+} // namespace yay
@@ -0,0 +1,148 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+#include <yay/yay_string_pool_image.h>
+#include <vector>
+
+namespace yay {
+
+int MappedUniqueCharPool::serialize( const UniqueCharPool& pool, std::ostream& fp )
+{
+	size_t numStrings = pool.getMaxId();
+	size_t numSlots = 1;
+	while( numSlots < 2*numStrings ) // load factor <= .5
+		numSlots <<= 1;
+
+	std::vector< uint64_t > offset( numStrings+1 );
+	std::vector< uint32_t > slot( numSlots, ID_NOTFOUND );
+	uint64_t blobSz = 0;
+	for( size_t id = 0; id< numStrings; ++id ) {
+		const char* s = pool.printableStr(id);
+		size_t s_len = pool.getLength(id);
+		offset[id] = blobSz;
+		blobSz += s_len+1;
+
+		size_t i = hash(s,s_len,pool.isCaseFold()) & (numSlots-1);
+		while( slot[i] != ID_NOTFOUND ) 
+			i = ( i+1 ) & (numSlots-1);
+		slot[i] = id;
+	}
+	offset[numStrings] = blobSz;
+
+	binary_image_header hdr( imageMagic(), IMAGE_VERSION, sizeof(uint64_t), sizeof(uint32_t), numStrings, numSlots );
+	hdr.flags = HASH_CHAR_SPAN | ( pool.isCaseFold() ? IMAGE_CASE_FOLD : 0 );
+	binary_image_write( fp, &hdr, sizeof(hdr) );
+	binary_image_write( fp, &(offset[0]), offset.size()*sizeof(uint64_t) );
+	binary_image_write( fp, &(slot[0]), slot.size()*sizeof(uint32_t) );
+	for( size_t id = 0; id< numStrings; ++id ) {
+		const char* s = pool.printableStr(id);
+		fp.write( s, offset[id+1]-offset[id] );
+	}
+	static const char zeroes[BINARY_IMAGE_ALIGN] = {0};
+	fp.write( zeroes, binary_image_align(blobSz)-blobSz );
+	return ( fp.good() ? 0 : -1 );
+}
+
+void MappedUniqueCharPool::clear()
+{
+	d_offset = 0;
+	d_slot = 0;
+	d_blob = 0;
+	d_numStrings = 0;
+	d_slotMask = 0;
+	d_blobSz = 0;
+	d_caseFold = false;
+	d_mmap.reset();
+}
+
+int MappedUniqueCharPool::attach( const char* buf, size_t buf_sz )
+{
+	clear();
+	if( buf_sz < sizeof(binary_image_header) ) 
+		return -1;
+	const binary_image_header* hdr = (const binary_image_header*)buf;
+	if( !hdr->matches( imageMagic(), IMAGE_VERSION, sizeof(uint64_t), sizeof(uint32_t) ) || 
+		( hdr->flags & HASH_ID_MASK ) != HASH_CHAR_SPAN || ( hdr->flags & ~(uint32_t)(HASH_ID_MASK|IMAGE_CASE_FOLD) ) 
+	) 
+		return -1;
+	// slots must be a power of 2 with load factor <= .5 (as serialize builds them) so that 
+	// probing always reaches an empty slot
+	if( !hdr->numAux || (hdr->numAux & (hdr->numAux-1)) || hdr->numElem > hdr->numAux/2 ) 
+		return -1;
+	// sizes are checked before they are multiplied so that a corrupt header cant wrap them
+	if( hdr->numElem >= buf_sz/sizeof(uint64_t) || hdr->numAux > buf_sz/sizeof(uint32_t) ) 
+		return -1;
+
+	size_t offsetOffset = binary_image_align( sizeof(binary_image_header) );
+	size_t slotOffset = offsetOffset + binary_image_align( (hdr->numElem+1)*sizeof(uint64_t) );
+	size_t blobOffset = slotOffset + binary_image_align( hdr->numAux*sizeof(uint32_t) );
+	if( blobOffset > buf_sz ) 
+		return -1;
+	const uint64_t* offset = (const uint64_t*)(buf+offsetOffset);
+	const uint32_t* slot = (const uint32_t*)(buf+slotOffset);
+	const char* blob = buf+blobOffset;
+	// only the last offset is read here - pages of a mapped image are touched by lookups only. 
+	// verify() checks everything else
+	if( offset[hdr->numElem] > buf_sz - blobOffset ) 
+		return -1;
+
+	d_offset = offset;
+	d_slot = slot;
+	d_blob = blob;
+	d_numStrings = hdr->numElem;
+	d_slotMask = hdr->numAux-1;
+	d_blobSz = buf_sz - blobOffset;
+	d_caseFold = ( hdr->flags & IMAGE_CASE_FOLD );
+	return 0;
+}
+
+int MappedUniqueCharPool::verify() const
+{
+	// every string ends with its terminating 0 within the blob
+	if( d_numStrings && d_offset[0] ) 
+		return -1;
+	for( size_t id = 0; id< d_numStrings; ++id ) {
+		if( d_offset[id+1] <= d_offset[id] || d_offset[id+1] > d_blobSz || d_blob[d_offset[id+1]-1] ) 
+			return -1;
+	}
+	size_t numUsed = 0;
+	for( size_t i = 0; i<= d_slotMask && d_slot; ++i ) {
+		if( d_slot[i] == ID_NOTFOUND ) 
+			continue;
+		if( d_slot[i] >= d_numStrings || ++numUsed > d_numStrings ) 
+			return -1;
+	}
+	return 0;
+}
+
+int MappedUniqueCharPool::load( const char* path )
+{
+	std::shared_ptr<mmap_file> m( new mmap_file );
+	if( m->open(path) || attach( m->data(), m->size() ) ) 
+		return -1;
+	d_mmap = m;
+	return 0;
+}
+
+} // namespace yay
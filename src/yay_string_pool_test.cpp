@@ -0,0 +1,143 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+
+/// lookups by (pointer, length) into buffers that aren't 0 terminated - every pool and dictionary 
+/// must look at exactly s_len bytes. the words are cut out of one unterminated heap block, so a 
+/// read past the end shows up under a sanitizer and a strlen based lookup fails the checks
+#include <string>
+#include <yay/yay_string_pool.h>
+#include <yay/yay_string_pool_concurrent.h>
+#include <yay/yay_string_pool_generational.h>
+#include <yay/yay_string_pool_image.h>
+#include <yay/yay_string_dict.h>
+#include "yay_test.h"
+
+namespace {
+
+/// "hellohelpworld" with no terminal 0 
+struct unterminated_text {
+	std::vector< char > buf;
+
+	unterminated_text() 
+	{
+		const char s[] = "hellohelpworld";
+		buf.assign( s, s+sizeof(s)-1 );
+	}
+	const char* hello() const { return &(buf[0]); }    // 5 bytes
+	const char* help() const { return &(buf[5]); }     // 4 bytes
+	const char* world() const { return &(buf[9]); }    // 5 bytes, ends the block
+};
+
+/// P has internIt / getId( const char*, size_t ) / resolveId
+template <typename P>
+void checkPool( P& p, const unterminated_text& txt )
+{
+	uint32_t hello = p.internIt( txt.hello(), 5 );
+	uint32_t world = p.internIt( txt.world(), 5 );
+	YAY_TEST_CHECK( !strcmp( p.resolveId(hello), "hello" ) );
+	YAY_TEST_CHECK( !strcmp( p.resolveId(world), "world" ) );
+	YAY_TEST_CHECK( p.getId( txt.hello(), 5 ) == hello );
+	YAY_TEST_CHECK( p.getId( txt.world(), 5 ) == world );
+	YAY_TEST_CHECK( p.getId( "hello" ) == hello );
+	YAY_TEST_CHECK( p.getId( txt.hello(), 4 ) == (uint32_t)P::ID_NOTFOUND );
+	YAY_TEST_CHECK( p.getId( txt.help(), 4 ) == (uint32_t)P::ID_NOTFOUND );
+	YAY_TEST_CHECK( p.getId( txt.world(), 3 ) == (uint32_t)P::ID_NOTFOUND );
+	YAY_TEST_CHECK( p.internIt( txt.hello(), 5 ) == hello );
+}
+
+void testUniqueCharPool( const unterminated_text& txt )
+{
+	yay::UniqueCharPool p;
+	checkPool( p, txt );
+	p.enableBloomFilter();
+	YAY_TEST_CHECK( p.getId( txt.hello(), 5 ) == p.getId("hello") );
+	YAY_TEST_CHECK( p.getId( txt.help(), 4 ) == yay::UniqueCharPool::ID_NOTFOUND );
+	YAY_TEST_CHECK( !p.freeze() );
+	YAY_TEST_CHECK( p.getId( txt.hello(), 5 ) == p.getId("hello") );
+	YAY_TEST_CHECK( p.getId( txt.world(), 5 ) == p.getId("world") );
+	YAY_TEST_CHECK( p.getId( txt.hello(), 4 ) == yay::UniqueCharPool::ID_NOTFOUND );
+	YAY_TEST_CHECK( p.getId( txt.help(), 4 ) == yay::UniqueCharPool::ID_NOTFOUND );
+
+	yay::UniqueCharPool f( yay::CharPool::DEFAULT_CHUNK_SIZE, yay::UniqueCharPool::POOL_CASE_FOLD );
+	checkPool( f, txt );
+	YAY_TEST_CHECK( f.getId( "WORLD" ) == f.getId( txt.world(), 5 ) );
+}
+
+void testConcurrentPool( const unterminated_text& txt )
+{
+	yay::ConcurrentUniqueCharPool p;
+	checkPool( p, txt );
+}
+
+void testGenerationalPool( const unterminated_text& txt )
+{
+	yay::GenerationalCharPool p;
+	checkPool( p, txt );
+}
+
+void testMappedPool( const unterminated_text& txt )
+{
+	yay::UniqueCharPool p;
+	p.internIt( "hello" );
+	p.internIt( "world" );
+	std::ostringstream fp;
+	YAY_TEST_CHECK( !yay::MappedUniqueCharPool::serialize( p, fp ) );
+	yay::test::aligned_image img( fp.str() );
+	yay::MappedUniqueCharPool m;
+	YAY_TEST_CHECK( !m.attach( img.data(), img.size() ) );
+	YAY_TEST_CHECK( m.getId( txt.hello(), 5 ) == p.getId("hello") );
+	YAY_TEST_CHECK( m.getId( txt.world(), 5 ) == p.getId("world") );
+	YAY_TEST_CHECK( m.getId( txt.hello(), 4 ) == yay::MappedUniqueCharPool::ID_NOTFOUND );
+	YAY_TEST_CHECK( m.getId( txt.help(), 4 ) == yay::MappedUniqueCharPool::ID_NOTFOUND );
+}
+
+void testStringDict( const unterminated_text& txt )
+{
+	std::vector< std::string > words;
+	words.push_back( "hello" );
+	words.push_back( "hell" );
+	words.push_back( "world" );
+	yay::FrontCodedStringDict d;
+	d.build( words );
+	YAY_TEST_CHECK( d.getId( yay::char_span( txt.hello(), 5 ) ) == d.getId( yay::char_span("hello") ) );
+	YAY_TEST_CHECK( d.getId( yay::char_span( txt.hello(), 4 ) ) == d.getId( yay::char_span("hell") ) );
+	YAY_TEST_CHECK( d.getId( yay::char_span( txt.world(), 5 ) ) == d.getId( yay::char_span("world") ) );
+	YAY_TEST_CHECK( d.getId( yay::char_span( txt.hello(), 5 ) ) != yay::FrontCodedStringDict::ID_NOTFOUND );
+	YAY_TEST_CHECK( d.getId( yay::char_span( txt.help(), 4 ) ) == yay::FrontCodedStringDict::ID_NOTFOUND );
+	YAY_TEST_CHECK( d.getId( yay::char_span( txt.world(), 3 ) ) == yay::FrontCodedStringDict::ID_NOTFOUND );
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+	unterminated_text txt;
+	testUniqueCharPool( txt );
+	testConcurrentPool( txt );
+	testGenerationalPool( txt );
+	testMappedPool( txt );
+	testStringDict( txt );
+	return yay::test::exitCode();
+}
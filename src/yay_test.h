@@ -0,0 +1,72 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+
+#pragma once
+/// bits shared by the self checking test programs (src/*_test.cpp, run by ctest)
+/// each program returns the number of failed checks, 0 - all passed
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+namespace yay {
+namespace test {
+
+inline size_t& numFailed() 
+{
+	static size_t n = 0;
+	return n;
+}
+
+inline int exitCode() 
+{
+	if( numFailed() ) 
+		std::cerr << numFailed() << " check(s) failed\n";
+	return ( numFailed() ? 1 : 0 );
+}
+
+/// copy of a serialized image in memory aligned at BINARY_IMAGE_ALIGN (attach needs that)
+struct aligned_image {
+	std::vector< uint64_t > buf;
+	size_t sz;
+
+	aligned_image( const std::string& img ) : buf( img.size()/sizeof(uint64_t)+1 ), sz( img.size() ) 
+		{ memcpy( &(buf[0]), img.data(), img.size() ); }
+	const char* data() const { return (const char*)&(buf[0]); }
+	size_t size() const { return sz; }
+};
+
+} // namespace test
+} // namespace yay
+
+#define YAY_TEST_CHECK(x) \
+	do { \
+		if( !(x) ) { \
+			++yay::test::numFailed(); \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #x "\n"; \
+		} \
+	} while(0)
@@ -0,0 +1,188 @@
+/*============================================================================
+The MIT License (MIT)
+
+Copyright (c) 2014 Andre Yanpolsky, Max Eronin, Georg Rudoy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+============================================================================*/
+
+
+/// trie search checks: parallel build against sequential adds, fuzzy search and top-K completion 
+/// against brute force over the word list
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <yay/yay_trie_parallel.h>
+#include <yay/yay_trie_fuzzy.h>
+#include <yay/yay_trie_topk.h>
+#include "yay_test.h"
+
+namespace {
+
+typedef yay::char_trie<uint32_t> CharTrie;
+typedef std::pair< std::string, uint32_t > Word;
+enum : uint32_t { NO_VALUE = 0xffffffff };
+
+std::string randomWord( std::mt19937& rng, size_t minLen, size_t maxLen, char numLetters )
+{
+	std::string w;
+	for( size_t i = 0, len = minLen + rng()%(maxLen-minLen+1); i< len; ++i ) 
+		w.push_back( (char)( 'a' + rng()%numLetters ) );
+	return w;
+}
+
+/// every key=data pair in the trie in depth first order
+void dumpTrie( const yay::trie<char,uint32_t>& t, std::string& path, std::vector< std::string >& out )
+{
+	for( yay::trie<char,uint32_t>::VecMap::const_iterator i = t.childBegin(); i!= t.childEnd(); ++i ) {
+		path.push_back( i->first );
+		std::ostringstream s;
+		s << path << "=" << i->second.get().data();
+		out.push_back( s.str() );
+		dumpTrie( i->second.get(), path, out );
+		path.erase( path.size()-1 );
+	}
+}
+
+void testParallelBuild()
+{
+	std::mt19937 rng(3);
+	std::vector< Word > words;
+	for( uint32_t i = 0; i< 100000; ++i ) 
+		words.push_back( Word( randomWord(rng,1,12,8), i ) );
+	auto add = []( CharTrie& t, const Word& w ) { t.add( w.first.c_str(), w.second, NO_VALUE ); };
+	auto upd = []( uint32_t mine, uint32_t theirs ) { return ( theirs == NO_VALUE ? mine : theirs ); };
+
+	CharTrie serial;
+	for( size_t i = 0; i< words.size(); ++i ) 
+		add( serial, words[i] );
+	std::vector< std::string > expected;
+	std::string path;
+	dumpTrie( serial, path, expected );
+
+	const size_t threads[] = { 2, 3, 5 };
+	for( size_t t = 0; t< sizeof(threads)/sizeof(threads[0]); ++t ) {
+		CharTrie parallel;
+		yay::trie_parallel_build( parallel, words.begin(), words.end(), add, upd, threads[t] );
+		std::vector< std::string > got;
+		dumpTrie( parallel, path, got );
+		YAY_TEST_CHECK( got == expected );
+	}
+}
+
+int editDistance( const std::string& a, const std::string& b )
+{
+	std::vector< int > prev( b.size()+1 ), cur( b.size()+1 );
+	for( size_t j = 0; j<= b.size(); ++j ) 
+		prev[j] = j;
+	for( size_t i = 1; i<= a.size(); ++i ) {
+		cur[0] = i;
+		for( size_t j = 1; j<= b.size(); ++j ) 
+			cur[j] = std::min( std::min( prev[j]+1, cur[j-1]+1 ), prev[j-1] + ( a[i-1] != b[j-1] ) );
+		prev.swap( cur );
+	}
+	return prev[ b.size() ];
+}
+
+void testFuzzy()
+{
+	std::mt19937 rng(3);
+	CharTrie t;
+	std::map< std::string, uint32_t > words;
+	for( uint32_t i = 0; i< 3000; ++i ) {
+		std::string w = randomWord( rng, 1, 7, 4 );
+		words[w] = i;
+		t.add( w.c_str(), i, NO_VALUE );
+	}
+	typedef yay::trie_fuzzy_matcher< CharTrie > Fuzzy;
+	Fuzzy fuzzy;
+	for( int q = 0; q< 300; ++q ) {
+		std::string query = randomWord( rng, 0, 7, 5 );
+		int maxDist = rng()%3;
+		std::vector< Fuzzy::match > res;
+		fuzzy.search( t, query.c_str(), maxDist, res, NO_VALUE );
+
+		std::map< std::string, int > got, expected;
+		for( size_t i = 0; i< res.size(); ++i ) {
+			std::string key( res[i].key.begin(), res[i].key.end() );
+			got[key] = res[i].distance;
+			YAY_TEST_CHECK( words.count(key) && words[key] == res[i].data );
+		}
+		for( std::map< std::string, uint32_t >::const_iterator w = words.begin(); w!= words.end(); ++w ) {
+			int d = editDistance( w->first, query );
+			if( d<= maxDist ) 
+				expected[w->first] = d;
+		}
+		YAY_TEST_CHECK( got == expected );
+	}
+}
+
+void testTopK()
+{
+	std::mt19937 rng(9);
+	std::map< std::string, uint32_t > words;
+	std::vector< double > score;
+	CharTrie t;
+	for( int i = 0; i< 20000; ++i ) {
+		std::string w = randomWord( rng, 1, 10, 6 );
+		if( words.count(w) ) 
+			continue;
+		uint32_t id = score.size();
+		score.push_back( (rng()%100000)/7.0 );
+		words[w] = id;
+		t.add( w.c_str(), id, NO_VALUE );
+	}
+	typedef yay::topk_trie< uint32_t, double > TopK;
+	TopK topk( NO_VALUE );
+	topk.build( t, [&]( uint32_t id ) { return score[id]; } );
+	for( int q = 0; q< 1000; ++q ) {
+		std::string prefix = randomWord( rng, 0, 3, 7 );
+		size_t k = 1 + rng()%20;
+		std::vector< TopK::result > res;
+		topk.topK( prefix.c_str(), k, res );
+
+		std::vector< std::pair< double, std::string > > expected;
+		for( std::map< std::string, uint32_t >::const_iterator w = words.begin(); w!= words.end(); ++w ) {
+			if( !w->first.compare( 0, prefix.size(), prefix ) ) 
+				expected.push_back( std::make_pair( score[w->second], w->first ) );
+		}
+		std::sort( expected.rbegin(), expected.rend() );
+		if( expected.size() > k ) 
+			expected.resize( k );
+
+		YAY_TEST_CHECK( res.size() == expected.size() );
+		for( size_t i = 0; i< res.size() && i< expected.size(); ++i ) {
+			// ties can come in any order, scores can't
+			YAY_TEST_CHECK( res[i].score == expected[i].first );
+			YAY_TEST_CHECK( words.count(res[i].key) && words[res[i].key] == res[i].data );
+			YAY_TEST_CHECK( score[res[i].data] == res[i].score );
+		}
+	}
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+	testParallelBuild();
+	testFuzzy();
+	testTopK();
+	return yay::test::exitCode();
+}
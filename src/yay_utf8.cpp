@@ -43,6 +43,44 @@ namespace yay
 		}
 	}
 
+	namespace
+	{
+		/// tableU2L spread over 256 code point pages for the BMP - only pages 
+		/// with mappings are allocated
+		struct fold_pages
+		{
+			std::vector<uint32_t> fold[256];
+
+			fold_pages()
+			{
+				for (size_t i = 0; i < sizeof(tableU2L) / sizeof(tableU2L[0]); ++i)
+				{
+					uint32_t cp = tableU2L[i][0];
+					if (cp > 0xFFFF)
+						continue;
+					std::vector<uint32_t>& page = fold[cp >> 8];
+					if (page.empty())
+						for (uint32_t j = 0; j < 256; ++j)
+							page.push_back((cp & ~0xFFu) | j);
+					page[cp & 0xFF] = tableU2L[i][1];
+				}
+			}
+		};
+	}
+
+	uint32_t utf32_fold(uint32_t cp)
+	{
+		static const fold_pages pages;
+		if (cp <= 0xFFFF)
+		{
+			const std::vector<uint32_t>& page = pages.fold[cp >> 8];
+			return (page.empty() ? cp : page[cp & 0xFF]);
+		}
+		p_t *end = tableU2L + sizeof(tableU2L) / sizeof(tableU2L[0]);
+		p_t *pair = std::lower_bound(tableU2L, end, cp, fstComp);
+		return ((pair == end || (*pair)[0] != cp) ? cp : (*pair)[1]);
+	}
+
 	bool CharUTF8::toLower()
 	{
 		const uint32_t utf32 = toUTF32();